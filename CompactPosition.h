@@ -0,0 +1,434 @@
+#ifndef LIBCHESS_COMPACTPOSITION_H
+#define LIBCHESS_COMPACTPOSITION_H
+
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+
+#include "Bitboard.h"
+#include "CastlingRights.h"
+#include "Color.h"
+#include "Lookups.h"
+#include "Move.h"
+#include "PieceType.h"
+#include "Position.h"
+#include "Square.h"
+#include "internal/Zobrist.h"
+
+namespace libchess {
+
+// A trivially copyable snapshot of a position without move history, meant to be copied instead
+// of unmade (copy-make) and to be handed between threads. Moves are made in place, so the parent
+// is kept by copying it before the move.
+class CompactPosition {
+   public:
+    using hash_type = Position::hash_type;
+
+    explicit CompactPosition(const Position& pos)
+        : hash_(pos.hash()),
+          side_to_move_(pos.side_to_move().value()),
+          castling_rights_(pos.castling_rights().value()),
+          enpassant_square_(pos.enpassant_square() ? pos.enpassant_square()->value()
+                                                   : NO_ENPASSANT_SQUARE),
+          halfmoves_(pos.halfmoves()),
+          fullmoves_(pos.fullmoves()) {
+        for (PieceType pt : constants::PIECE_TYPES) {
+            piece_type_bb_[pt.value()] = pos.piece_type_bb(pt);
+        }
+        for (Color c : constants::COLORS) {
+            color_bb_[c.value()] = pos.color_bb(c);
+        }
+    }
+
+    // Conversion is meant to be cheap: the history grows on the first move and the start FEN is
+    // only derived if start_fen() is asked for
+    Position to_position() const {
+        Position pos;
+        pos.history_.push_back(Position::State{});
+        for (Color c : constants::COLORS) {
+            for (PieceType pt : constants::PIECE_TYPES) {
+                Bitboard bb = piece_type_bb(pt, c);
+                while (bb) {
+                    pos.put_piece(bb.forward_bitscan(), pt, c);
+                    bb.forward_popbit();
+                }
+            }
+        }
+        pos.side_to_move_ = side_to_move();
+        pos.fullmoves_ = fullmoves();
+        Position::State& curr_state = pos.state_mut_ref();
+        curr_state.set_castling_rights(castling_rights());
+        curr_state.set_enpassant_square(enpassant_square());
+        curr_state.halfmoves_ = halfmoves();
+        pos.reset_state_keys();
+        return pos;
+    }
+
+    // Getters
+    Bitboard piece_type_bb(PieceType piece_type) const {
+        return piece_type_bb_[piece_type.value()];
+    }
+    Bitboard piece_type_bb(PieceType piece_type, Color color) const {
+        return piece_type_bb_[piece_type.value()] & color_bb(color);
+    }
+    Bitboard color_bb(Color color) const {
+        return color_bb_[color.value()];
+    }
+    Bitboard occupancy_bb() const {
+        return color_bb_[0] | color_bb_[1];
+    }
+    Color side_to_move() const {
+        return Color{side_to_move_};
+    }
+    CastlingRights castling_rights() const {
+        return CastlingRights{castling_rights_};
+    }
+    std::optional<Square> enpassant_square() const {
+        if (enpassant_square_ == NO_ENPASSANT_SQUARE) {
+            return std::nullopt;
+        }
+        return Square{enpassant_square_};
+    }
+    int halfmoves() const {
+        return halfmoves_;
+    }
+    int fullmoves() const {
+        return fullmoves_;
+    }
+    hash_type hash() const {
+        return hash_;
+    }
+    Square king_square(Color color) const {
+        return piece_type_bb(constants::KING, color).forward_bitscan();
+    }
+    std::optional<PieceType> piece_type_on(Square square) const {
+        for (PieceType piece_type : constants::PIECE_TYPES) {
+            if (piece_type_bb(piece_type) & Bitboard{square}) {
+                return piece_type;
+            }
+        }
+        return std::nullopt;
+    }
+
+    // Attacks
+    Bitboard attackers_to(Square square, Bitboard occupancy, Color c) const {
+        Bitboard bishops_queens =
+            piece_type_bb(constants::BISHOP) | piece_type_bb(constants::QUEEN);
+        Bitboard rooks_queens = piece_type_bb(constants::ROOK) | piece_type_bb(constants::QUEEN);
+        return color_bb(c) &
+               ((lookups::pawn_attacks(square, !c) & piece_type_bb(constants::PAWN)) |
+                (lookups::knight_attacks(square) & piece_type_bb(constants::KNIGHT)) |
+                (lookups::king_attacks(square) & piece_type_bb(constants::KING)) |
+                (lookups::bishop_attacks(square, occupancy) & bishops_queens) |
+                (lookups::rook_attacks(square, occupancy) & rooks_queens));
+    }
+    Bitboard attackers_to(Square square, Color c) const {
+        return attackers_to(square, occupancy_bb(), c);
+    }
+    Bitboard checkers_to(Color c) const {
+        return attackers_to(king_square(c), !c);
+    }
+    bool in_check() const {
+        return checkers_to(side_to_move()) != 0;
+    }
+    // Pieces of color c that are the only piece between an enemy slider and c's king
+    Bitboard pinned_pieces_of(Color c) const {
+        Square king_sq = king_square(c);
+        Bitboard occupancy = occupancy_bb();
+        Bitboard snipers =
+            (((piece_type_bb(constants::ROOK) | piece_type_bb(constants::QUEEN)) &
+              lookups::rook_attacks(king_sq)) |
+             ((piece_type_bb(constants::BISHOP) | piece_type_bb(constants::QUEEN)) &
+              lookups::bishop_attacks(king_sq))) &
+            color_bb(!c);
+        Bitboard pinned;
+        while (snipers) {
+            Square sniper_sq = snipers.forward_bitscan();
+            snipers.forward_popbit();
+            Bitboard blockers = lookups::intervening(sniper_sq, king_sq) & occupancy;
+            if (blockers.popcount() == 1) {
+                pinned |= blockers & color_bb(c);
+            }
+        }
+        return pinned;
+    }
+
+    // Move Generation
+    // Fully legal moves from check and pin masks, typed like Position's generated moves, so a
+    // copy-make search never has to convert to a Position
+    void generate_legal_moves(MoveList& move_list) const {
+        Color stm = side_to_move();
+        Color them = !stm;
+        Bitboard occupancy = occupancy_bb();
+        Bitboard opp_occupancy = color_bb(them);
+        Square king_sq = king_square(stm);
+        Bitboard checkers = attackers_to(king_sq, occupancy, them);
+
+        Bitboard non_king_occupancy = occupancy ^ Bitboard{king_sq};
+        Bitboard king_targets = lookups::king_attacks(king_sq) & ~color_bb(stm);
+        while (king_targets) {
+            Square to_sq = king_targets.forward_bitscan();
+            king_targets.forward_popbit();
+            if (!attackers_to(to_sq, non_king_occupancy, them)) {
+                add_move(move_list, king_sq, to_sq, opp_occupancy);
+            }
+        }
+        if (checkers.popcount() > 1) {
+            return;
+        }
+
+        Bitboard check_mask = ~Bitboard{};
+        if (checkers) {
+            check_mask = checkers | lookups::intervening(king_sq, checkers.forward_bitscan());
+        } else {
+            generate_castling(move_list);
+        }
+        Bitboard pinned = pinned_pieces_of(stm);
+        for (PieceType pt = constants::KNIGHT; pt <= constants::QUEEN; ++pt) {
+            Bitboard piece_bb = piece_type_bb(pt, stm);
+            while (piece_bb) {
+                Square from_sq = piece_bb.forward_bitscan();
+                piece_bb.forward_popbit();
+                Bitboard targets = lookups::non_pawn_piece_type_attacks(pt, from_sq, occupancy) &
+                                   ~color_bb(stm) & check_mask;
+                if (pinned & Bitboard{from_sq}) {
+                    targets &= lookups::full_ray(king_sq, from_sq);
+                }
+                while (targets) {
+                    add_move(move_list, from_sq, targets.forward_bitscan(), opp_occupancy);
+                    targets.forward_popbit();
+                }
+            }
+        }
+        generate_pawn_moves(move_list, king_sq, check_mask, pinned);
+    }
+    MoveList legal_move_list() const {
+        MoveList move_list;
+        generate_legal_moves(move_list);
+        return move_list;
+    }
+
+    // Move Integration
+    void make_move(Move move) {
+        Color stm = side_to_move();
+        Square from_square = move.from_square();
+        Square to_square = move.to_square();
+        PieceType moving_pt = *piece_type_on(from_square);
+        auto captured_pt = piece_type_on(to_square);
+        auto promotion_pt = move.promotion_piece_type();
+
+        hash_ ^= enpassant_hash();
+        hash_ ^= zobrist::castling_rights_key(castling_rights());
+        enpassant_square_ = NO_ENPASSANT_SQUARE;
+        castling_rights_ &= Position::castling_spoilers[from_square.value()] &
+                            Position::castling_spoilers[to_square.value()];
+        ++halfmoves_;
+        if (stm == constants::BLACK) {
+            ++fullmoves_;
+        }
+
+        if (captured_pt) {
+            remove_piece(to_square, *captured_pt, !stm);
+            halfmoves_ = 0;
+        }
+        if (promotion_pt) {
+            remove_piece(from_square, constants::PAWN, stm);
+            put_piece(to_square, *promotion_pt, stm);
+        } else {
+            move_piece(from_square, to_square, moving_pt, stm);
+        }
+
+        if (moving_pt == constants::PAWN) {
+            halfmoves_ = 0;
+            int sq_diff = to_square - from_square;
+            if (sq_diff == 16 || sq_diff == -16) {
+                enpassant_square_ = (from_square.value() + to_square.value()) / 2;
+            } else if (!captured_pt && (sq_diff & 1)) {
+                remove_piece(lookups::pawn_shift(to_square, !stm), constants::PAWN, !stm);
+            }
+        } else if (moving_pt == constants::KING && (to_square - from_square == 2 ||
+                                                    to_square - from_square == -2)) {
+            switch (to_square) {
+                case constants::C1:
+                    move_piece(constants::A1, constants::D1, constants::ROOK, stm);
+                    break;
+                case constants::G1:
+                    move_piece(constants::H1, constants::F1, constants::ROOK, stm);
+                    break;
+                case constants::C8:
+                    move_piece(constants::A8, constants::D8, constants::ROOK, stm);
+                    break;
+                case constants::G8:
+                    move_piece(constants::H8, constants::F8, constants::ROOK, stm);
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        side_to_move_ = (!stm).value();
+        hash_ ^= zobrist::side_to_move_key();
+        hash_ ^= zobrist::castling_rights_key(castling_rights());
+        hash_ ^= enpassant_hash();
+    }
+    void make_null_move() {
+        hash_ ^= enpassant_hash();
+        enpassant_square_ = NO_ENPASSANT_SQUARE;
+        ++halfmoves_;
+        if (side_to_move() == constants::BLACK) {
+            ++fullmoves_;
+        }
+        side_to_move_ = (!side_to_move()).value();
+        hash_ ^= zobrist::side_to_move_key();
+    }
+    // Copy-make: returns the position after the move, leaving this one untouched
+    CompactPosition after(Move move) const {
+        CompactPosition next = *this;
+        next.make_move(move);
+        return next;
+    }
+
+   private:
+    constexpr static std::uint8_t NO_ENPASSANT_SQUARE = 64;
+
+    static void add_move(MoveList& move_list, Square from_sq, Square to_sq, Bitboard opp_occupancy) {
+        move_list.add(Move{from_sq, to_sq,
+                           (opp_occupancy & Bitboard{to_sq}) ? Move::Type::CAPTURE
+                                                             : Move::Type::NORMAL});
+    }
+    static void add_pawn_moves(MoveList& move_list,
+                               Square from_sq,
+                               Bitboard targets,
+                               Move::Type type,
+                               Move::Type promotion_type,
+                               Bitboard promotion_rank) {
+        while (targets) {
+            Square to_sq = targets.forward_bitscan();
+            targets.forward_popbit();
+            if (promotion_rank & Bitboard{to_sq}) {
+                move_list.add(Move{from_sq, to_sq, constants::QUEEN, promotion_type});
+                move_list.add(Move{from_sq, to_sq, constants::KNIGHT, promotion_type});
+                move_list.add(Move{from_sq, to_sq, constants::ROOK, promotion_type});
+                move_list.add(Move{from_sq, to_sq, constants::BISHOP, promotion_type});
+            } else {
+                move_list.add(Move{from_sq, to_sq, type});
+            }
+        }
+    }
+    void generate_pawn_moves(MoveList& move_list,
+                             Square king_sq,
+                             Bitboard check_mask,
+                             Bitboard pinned) const {
+        Color stm = side_to_move();
+        Color them = !stm;
+        Bitboard occupancy = occupancy_bb();
+        Bitboard promotion_rank = lookups::relative_rank_mask(constants::RANK_8, stm);
+        Bitboard double_push_rank = lookups::relative_rank_mask(constants::RANK_3, stm);
+        auto ep_sq = enpassant_square();
+        Bitboard pawn_bb = piece_type_bb(constants::PAWN, stm);
+        while (pawn_bb) {
+            Square from_sq = pawn_bb.forward_bitscan();
+            pawn_bb.forward_popbit();
+            Bitboard allowed = check_mask;
+            if (pinned & Bitboard{from_sq}) {
+                allowed &= lookups::full_ray(king_sq, from_sq);
+            }
+            Bitboard single_push = lookups::pawn_shift(Bitboard{from_sq}, stm) & ~occupancy;
+            Bitboard double_push =
+                lookups::pawn_shift(single_push & double_push_rank, stm) & ~occupancy;
+            Bitboard captures = lookups::pawn_attacks(from_sq, stm) & color_bb(them);
+            add_pawn_moves(move_list, from_sq, single_push & allowed, Move::Type::NORMAL,
+                           Move::Type::PROMOTION, promotion_rank);
+            add_pawn_moves(move_list, from_sq, double_push & allowed, Move::Type::DOUBLE_PUSH,
+                           Move::Type::DOUBLE_PUSH, promotion_rank);
+            add_pawn_moves(move_list, from_sq, captures & allowed, Move::Type::CAPTURE,
+                           Move::Type::CAPTURE_PROMOTION, promotion_rank);
+
+            // Enpassant removes two pieces from their squares, so it is checked on the resulting
+            // occupancy instead of the masks
+            if (ep_sq && (lookups::pawn_attacks(from_sq, stm) & Bitboard{*ep_sq})) {
+                Bitboard captured_bb = Bitboard{lookups::pawn_shift(*ep_sq, them)};
+                Bitboard ep_occupancy =
+                    (occupancy ^ Bitboard{from_sq} ^ captured_bb) | Bitboard{*ep_sq};
+                if (!(attackers_to(king_sq, ep_occupancy, them) & ~captured_bb)) {
+                    move_list.add(Move{from_sq, *ep_sq, Move::Type::ENPASSANT});
+                }
+            }
+        }
+    }
+    void generate_castling(MoveList& move_list) const {
+        const int castling_possibilities[2][2] = {
+            {constants::WHITE_KINGSIDE.value(), constants::WHITE_QUEENSIDE.value()},
+            {constants::BLACK_KINGSIDE.value(), constants::BLACK_QUEENSIDE.value()},
+        };
+        const Square castling_intermediate_sqs[2][2][2] = {
+            {{constants::F1, constants::G1}, {constants::D1, constants::C1}},
+            {{constants::F8, constants::G8}, {constants::D8, constants::C8}}};
+        const Square castling_king_sqs[2] = {constants::E1, constants::E8};
+        const Bitboard castle_mask[2][2] = {
+            {(Bitboard{constants::F1} | Bitboard{constants::G1}),
+             (Bitboard{constants::D1} | Bitboard{constants::C1} | Bitboard{constants::B1})},
+            {(Bitboard{constants::F8} | Bitboard{constants::G8}),
+             (Bitboard{constants::D8} | Bitboard{constants::C8} | Bitboard{constants::B8})}};
+
+        int c = side_to_move().value();
+        Color them = !side_to_move();
+        for (int side = 0; side < 2; ++side) {
+            if ((castling_possibilities[c][side] & castling_rights_) &&
+                !(castle_mask[c][side] & occupancy_bb()) &&
+                !attackers_to(castling_intermediate_sqs[c][side][0], them) &&
+                !attackers_to(castling_intermediate_sqs[c][side][1], them)) {
+                move_list.add(Move{castling_king_sqs[c], castling_intermediate_sqs[c][side][1],
+                                   Move::Type::CASTLING});
+            }
+        }
+    }
+
+    // The enpassant square is only hashed when the side to move can actually capture on it
+    hash_type enpassant_hash() const {
+        auto ep_sq = enpassant_square();
+        if (!ep_sq) {
+            return 0;
+        }
+        Color stm = side_to_move();
+        Bitboard ep_candidates =
+            piece_type_bb(constants::PAWN, stm) & lookups::pawn_attacks(*ep_sq, !stm);
+        return ep_candidates ? zobrist::enpassant_key(*ep_sq) : 0;
+    }
+
+    void put_piece(Square square, PieceType piece_type, Color color) {
+        Bitboard square_bb = Bitboard{square};
+        piece_type_bb_[piece_type.value()] |= square_bb;
+        color_bb_[color.value()] |= square_bb;
+        hash_ ^= zobrist::piece_square_key(square, piece_type, color);
+    }
+    void remove_piece(Square square, PieceType piece_type, Color color) {
+        Bitboard square_bb = Bitboard{square};
+        piece_type_bb_[piece_type.value()] &= ~square_bb;
+        color_bb_[color.value()] &= ~square_bb;
+        hash_ ^= zobrist::piece_square_key(square, piece_type, color);
+    }
+    void move_piece(Square from_square, Square to_square, PieceType piece_type, Color color) {
+        Bitboard from_to_sqs_bb = Bitboard{from_square} ^ Bitboard { to_square };
+        piece_type_bb_[piece_type.value()] ^= from_to_sqs_bb;
+        color_bb_[color.value()] ^= from_to_sqs_bb;
+        hash_ ^= zobrist::piece_square_key(from_square, piece_type, color) ^
+                 zobrist::piece_square_key(to_square, piece_type, color);
+    }
+
+    Bitboard piece_type_bb_[6];
+    Bitboard color_bb_[2];
+    hash_type hash_;
+    std::uint8_t side_to_move_;
+    std::uint8_t castling_rights_;
+    std::uint8_t enpassant_square_;
+    std::uint16_t halfmoves_;
+    std::uint16_t fullmoves_;
+};
+
+static_assert(std::is_trivially_copyable_v<CompactPosition>);
+static_assert(sizeof(CompactPosition) <= 96);
+
+}  // namespace libchess
+
+#endif  // LIBCHESS_COMPACTPOSITION_H
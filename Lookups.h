@@ -2,10 +2,21 @@
 #define LIBCHESS_LOOKUPS_H
 
 #include <array>
+#include <string>
+#include <vector>
 
 #include "Bitboard.h"
 #include "Color.h"
 #include "PieceType.h"
+#include "internal/MagicNumbers.h"
+
+// PEXT slider attacks are picked at runtime on x86-64 CPUs that have a fast BMI2 implementation.
+// Define LIBCHESS_NO_PEXT to always use the magic tables.
+#if !defined(LIBCHESS_RAY_ATTACKS) && !defined(LIBCHESS_NO_PEXT) && defined(__x86_64__) && \
+    defined(__GNUC__)
+#define LIBCHESS_PEXT_ATTACKS
+#include <immintrin.h>
+#endif
 
 namespace libchess::lookups {
 
@@ -43,10 +54,10 @@ constexpr static std::array<Bitboard, 8> FILE_MASK = {FILE_A_MASK,
                                             FILE_G_MASK,
                                             FILE_H_MASK};
 
-inline Bitboard rank_mask(Rank rank) {
+constexpr inline Bitboard rank_mask(Rank rank) {
     return RANK_MASK[rank.value()];
 }
-inline Bitboard file_mask(File file) {
+constexpr inline Bitboard file_mask(File file) {
     return FILE_MASK[file.value()];
 }
 
@@ -54,7 +65,7 @@ namespace init {
 
 constexpr inline std::array<Bitboard, 64> north() {
     std::array<Bitboard, 64> attacks{};
-    for (Square sq = constants::A1; sq <= constants::H7; ++sq) {
+    for (Square sq = constants::A1; sq <= constants::H8; ++sq) {
         Bitboard bb;
         for (Square atk_sq = sq + 8; atk_sq <= constants::H8; atk_sq = atk_sq + 8) {
             bb |= Bitboard{atk_sq};
@@ -66,7 +77,7 @@ constexpr inline std::array<Bitboard, 64> north() {
 
 constexpr inline std::array<Bitboard, 64> south() {
     std::array<Bitboard, 64> attacks{};
-    for (Square sq = constants::A2; sq <= constants::H8; ++sq) {
+    for (Square sq = constants::A1; sq <= constants::H8; ++sq) {
         Bitboard bb;
         for (Square atk_sq = sq - 8; atk_sq >= constants::A1; atk_sq = atk_sq - 8) {
             bb |= Bitboard{atk_sq};
@@ -78,7 +89,7 @@ constexpr inline std::array<Bitboard, 64> south() {
 
 constexpr inline std::array<Bitboard, 64> east() {
     std::array<Bitboard, 64> attacks{};
-    for (Square sq = constants::A1; sq <= constants::G8; ++sq) {
+    for (Square sq = constants::A1; sq <= constants::H8; ++sq) {
         Bitboard bb;
         for (Square atk_sq = sq + 1; atk_sq <= constants::H8; atk_sq = atk_sq + 1) {
             if (Bitboard{atk_sq} & FILE_A_MASK) {
@@ -93,7 +104,7 @@ constexpr inline std::array<Bitboard, 64> east() {
 
 constexpr inline std::array<Bitboard, 64> west() {
     std::array<Bitboard, 64> attacks{};
-    for (Square sq = constants::B1; sq <= constants::H8; ++sq) {
+    for (Square sq = constants::A1; sq <= constants::H8; ++sq) {
         Bitboard bb;
         for (Square atk_sq = sq - 1; atk_sq >= constants::A1; atk_sq = atk_sq - 1) {
             if (Bitboard{atk_sq} & FILE_H_MASK) {
@@ -108,7 +119,7 @@ constexpr inline std::array<Bitboard, 64> west() {
 
 constexpr inline std::array<Bitboard, 64> northwest() {
     std::array<Bitboard, 64> attacks{};
-    for (Square sq = constants::A1; sq <= constants::H7; ++sq) {
+    for (Square sq = constants::A1; sq <= constants::H8; ++sq) {
         Bitboard bb;
         for (Square atk_sq = sq + 7; atk_sq <= constants::H8; atk_sq = atk_sq + 7) {
             if (Bitboard{atk_sq} & FILE_H_MASK) {
@@ -123,7 +134,7 @@ constexpr inline std::array<Bitboard, 64> northwest() {
 
 constexpr inline std::array<Bitboard, 64> southwest() {
     std::array<Bitboard, 64> attacks{};
-    for (Square sq = constants::B2; sq <= constants::H8; ++sq) {
+    for (Square sq = constants::A1; sq <= constants::H8; ++sq) {
         Bitboard bb;
         for (Square atk_sq = sq - 9; atk_sq >= constants::A1; atk_sq = atk_sq - 9) {
             if (Bitboard{atk_sq} & FILE_H_MASK) {
@@ -138,7 +149,7 @@ constexpr inline std::array<Bitboard, 64> southwest() {
 
 constexpr inline std::array<Bitboard, 64> northeast() {
     std::array<Bitboard, 64> attacks{};
-    for (Square sq = constants::A1; sq <= constants::G7; ++sq) {
+    for (Square sq = constants::A1; sq <= constants::H8; ++sq) {
         Bitboard bb;
         for (Square atk_sq = sq + 9; atk_sq <= constants::H8; atk_sq = atk_sq + 9) {
             if (Bitboard{atk_sq} & FILE_A_MASK) {
@@ -153,7 +164,7 @@ constexpr inline std::array<Bitboard, 64> northeast() {
 
 constexpr inline std::array<Bitboard, 64> southeast() {
     std::array<Bitboard, 64> attacks{};
-    for (Square sq = constants::A2; sq <= constants::H8; ++sq) {
+    for (Square sq = constants::A1; sq <= constants::H8; ++sq) {
         Bitboard bb;
         for (Square atk_sq = sq - 7; atk_sq >= constants::A1; atk_sq = atk_sq - 7) {
             if (Bitboard{atk_sq} & FILE_A_MASK) {
@@ -380,8 +391,12 @@ constexpr inline Bitboard rook_attacks(Square square) {
 constexpr inline Bitboard queen_attacks(Square square) {
     return QUEEN_ATTACKS[square];
 }
+
+namespace ray {
+
+// Reference slider attacks: strips everything behind the first blocker on each ray.
 constexpr inline Bitboard bishop_attacks(Square square, Bitboard occupancy) {
-    Bitboard attacks = bishop_attacks(square);
+    Bitboard attacks = lookups::bishop_attacks(square);
     Bitboard nw_blockers = (northwest(square) & occupancy) | Bitboard{constants::A8};
     Bitboard ne_blockers = (northeast(square) & occupancy) | Bitboard{constants::H8};
     Bitboard sw_blockers = (southwest(square) & occupancy) | Bitboard{constants::A1};
@@ -393,8 +408,8 @@ constexpr inline Bitboard bishop_attacks(Square square, Bitboard occupancy) {
     attacks ^= southeast(se_blockers.reverse_bitscan());
     return attacks;
 }
-inline Bitboard rook_attacks(Square square, Bitboard occupancy) {
-    Bitboard attacks = rook_attacks(square);
+constexpr inline Bitboard rook_attacks(Square square, Bitboard occupancy) {
+    Bitboard attacks = lookups::rook_attacks(square);
     Bitboard n_blockers = (north(square) & occupancy) | Bitboard{constants::H8};
     Bitboard s_blockers = (south(square) & occupancy) | Bitboard{constants::A1};
     Bitboard w_blockers = (west(square) & occupancy) | Bitboard{constants::A1};
@@ -406,8 +421,8 @@ inline Bitboard rook_attacks(Square square, Bitboard occupancy) {
     attacks ^= east(e_blockers.forward_bitscan());
     return attacks;
 }
-inline Bitboard queen_attacks(Square square, Bitboard occupancy) {
-    Bitboard attacks = queen_attacks(square);
+constexpr inline Bitboard queen_attacks(Square square, Bitboard occupancy) {
+    Bitboard attacks = lookups::queen_attacks(square);
     Bitboard nw_blockers = (northwest(square) & occupancy) | Bitboard{constants::A8};
     Bitboard ne_blockers = (northeast(square) & occupancy) | Bitboard{constants::H8};
     Bitboard sw_blockers = (southwest(square) & occupancy) | Bitboard{constants::A1};
@@ -427,6 +442,195 @@ inline Bitboard queen_attacks(Square square, Bitboard occupancy) {
     attacks ^= east(e_blockers.forward_bitscan());
     return attacks;
 }
+
+}  // namespace ray
+
+struct Magic {
+    Bitboard mask;
+    std::uint64_t magic;
+    int shift;
+    int offset;
+
+    constexpr int index(Bitboard occupancy) const {
+        return offset + int(((occupancy & mask) * magic) >> shift);
+    }
+};
+
+namespace init {
+
+constexpr inline Bitboard slider_edges(Square square) {
+    return ((RANK_1_MASK | RANK_8_MASK) & ~rank_mask(square.rank())) |
+           ((FILE_A_MASK | FILE_H_MASK) & ~file_mask(square.file()));
+}
+
+constexpr inline std::array<Magic, 64> magics(const std::array<Bitboard, 64>& empty_attacks,
+                                              const std::uint64_t (&magic_numbers)[64]) {
+    std::array<Magic, 64> magics{};
+    int offset = 0;
+    for (Square sq = constants::A1; sq <= constants::H8; ++sq) {
+        Bitboard mask = empty_attacks[sq] & ~slider_edges(sq);
+        magics[sq] = Magic{mask, magic_numbers[sq.value()], 64 - mask.popcount(), offset};
+        offset += 1 << mask.popcount();
+    }
+    return magics;
+}
+
+template <std::size_t N>
+inline std::array<Bitboard, N> magic_attacks(const std::array<Magic, 64>& magics,
+                                             Bitboard (*slider_attacks)(Square, Bitboard)) {
+    std::array<Bitboard, N> attacks{};
+    for (Square sq = constants::A1; sq <= constants::H8; ++sq) {
+        const Magic& magic = magics[sq];
+        std::uint64_t occupancy = 0;
+        do {
+            attacks[magic.index(Bitboard{occupancy})] = slider_attacks(sq, Bitboard{occupancy});
+            occupancy = (occupancy - magic.mask) & magic.mask;
+        } while (occupancy);
+    }
+    return attacks;
+}
+
+}  // namespace init
+
+// Fancy magic slider attack tables
+constexpr static std::array<Magic, 64> BISHOP_MAGICS =
+    init::magics(BISHOP_ATTACKS, magics::bishop_magics);
+constexpr static std::array<Magic, 64> ROOK_MAGICS =
+    init::magics(ROOK_ATTACKS, magics::rook_magics);
+// The attack tables are too large to build as constant expressions, so they are filled in during
+// static initialization instead.
+inline const std::array<Bitboard, 5248> BISHOP_MAGIC_ATTACKS =
+    init::magic_attacks<5248>(BISHOP_MAGICS, ray::bishop_attacks);
+inline const std::array<Bitboard, 102400> ROOK_MAGIC_ATTACKS =
+    init::magic_attacks<102400>(ROOK_MAGICS, ray::rook_attacks);
+
+namespace magic {
+
+inline Bitboard bishop_attacks(Square square, Bitboard occupancy) {
+    return BISHOP_MAGIC_ATTACKS[BISHOP_MAGICS[square].index(occupancy)];
+}
+inline Bitboard rook_attacks(Square square, Bitboard occupancy) {
+    return ROOK_MAGIC_ATTACKS[ROOK_MAGICS[square].index(occupancy)];
+}
+inline Bitboard queen_attacks(Square square, Bitboard occupancy) {
+    return bishop_attacks(square, occupancy) | rook_attacks(square, occupancy);
+}
+
+}  // namespace magic
+
+#if defined(LIBCHESS_PEXT_ATTACKS)
+
+namespace init {
+
+template <std::size_t N>
+inline std::vector<Bitboard> pext_attacks(const std::array<Magic, 64>& magics,
+                                          Bitboard (*slider_attacks)(Square, Bitboard)) {
+    std::vector<Bitboard> attacks(N);
+    for (Square sq = constants::A1; sq <= constants::H8; ++sq) {
+        const Magic& magic = magics[sq];
+        int index = magic.offset;
+        std::uint64_t occupancy = 0;
+        // The carry-rippler walks the subsets of the mask in the same order PEXT numbers them
+        do {
+            attacks[index++] = slider_attacks(sq, Bitboard{occupancy});
+            occupancy = (occupancy - magic.mask) & magic.mask;
+        } while (occupancy);
+    }
+    return attacks;
+}
+
+inline bool has_fast_pext() {
+    __builtin_cpu_init();
+    // Zen 1 and Zen 2 implement PEXT in microcode, which loses to a magic multiply
+    return __builtin_cpu_supports("bmi2") && !__builtin_cpu_is("znver1") &&
+           !__builtin_cpu_is("znver2");
+}
+
+}  // namespace init
+
+// PEXT slider attack tables, sharing the masks and offsets of the magic tables. They are only built
+// when the runtime dispatch selects PEXT, so hosts using the magic tables don't pay for them.
+inline const bool HAS_FAST_PEXT = init::has_fast_pext();
+inline const std::vector<Bitboard> BISHOP_PEXT_ATTACKS =
+    HAS_FAST_PEXT ? init::pext_attacks<5248>(BISHOP_MAGICS, ray::bishop_attacks)
+                  : std::vector<Bitboard>{};
+inline const std::vector<Bitboard> ROOK_PEXT_ATTACKS =
+    HAS_FAST_PEXT ? init::pext_attacks<102400>(ROOK_MAGICS, ray::rook_attacks)
+                  : std::vector<Bitboard>{};
+
+// Only valid when HAS_FAST_PEXT is set
+namespace pext {
+
+inline std::uint64_t pext_u64(std::uint64_t value, std::uint64_t mask) {
+#if defined(__BMI2__)
+    return _pext_u64(value, mask);
+#else
+    // Unlike a target("bmi2") function, inline asm can still be inlined into generic callers
+    std::uint64_t result;
+    __asm__("pextq %2, %1, %0" : "=r"(result) : "r"(value), "r"(mask));
+    return result;
+#endif
+}
+
+inline Bitboard bishop_attacks(Square square, Bitboard occupancy) {
+    const Magic& magic = BISHOP_MAGICS[square];
+    return BISHOP_PEXT_ATTACKS[magic.offset + pext_u64(occupancy, magic.mask)];
+}
+inline Bitboard rook_attacks(Square square, Bitboard occupancy) {
+    const Magic& magic = ROOK_MAGICS[square];
+    return ROOK_PEXT_ATTACKS[magic.offset + pext_u64(occupancy, magic.mask)];
+}
+inline Bitboard queen_attacks(Square square, Bitboard occupancy) {
+    return bishop_attacks(square, occupancy) | rook_attacks(square, occupancy);
+}
+
+}  // namespace pext
+
+#endif
+
+// Slider attacks use the magic tables unless LIBCHESS_RAY_ATTACKS is defined or PEXT is available
+#if defined(LIBCHESS_RAY_ATTACKS)
+namespace slider = ray;
+#else
+namespace slider = magic;
+#endif
+
+inline Bitboard bishop_attacks(Square square, Bitboard occupancy) {
+#if defined(LIBCHESS_PEXT_ATTACKS)
+    if (HAS_FAST_PEXT) {
+        return pext::bishop_attacks(square, occupancy);
+    }
+#endif
+    return slider::bishop_attacks(square, occupancy);
+}
+inline Bitboard rook_attacks(Square square, Bitboard occupancy) {
+#if defined(LIBCHESS_PEXT_ATTACKS)
+    if (HAS_FAST_PEXT) {
+        return pext::rook_attacks(square, occupancy);
+    }
+#endif
+    return slider::rook_attacks(square, occupancy);
+}
+inline Bitboard queen_attacks(Square square, Bitboard occupancy) {
+#if defined(LIBCHESS_PEXT_ATTACKS)
+    if (HAS_FAST_PEXT) {
+        return pext::queen_attacks(square, occupancy);
+    }
+#endif
+    return slider::queen_attacks(square, occupancy);
+}
+inline std::string slider_attacks_backend() {
+#if defined(LIBCHESS_RAY_ATTACKS)
+    return "ray";
+#else
+#if defined(LIBCHESS_PEXT_ATTACKS)
+    if (HAS_FAST_PEXT) {
+        return "pext";
+    }
+#endif
+    return "magic";
+#endif
+}
 inline Bitboard pawn_shift(Bitboard bb, Color c, int times = 1) {
     return c == constants::WHITE ? bb << (8 * times) : bb >> (8 * times);
 }
@@ -441,6 +645,26 @@ inline Rank relative_rank(Rank rank, Color c) {
 inline Bitboard relative_rank_mask(Rank rank, Color c) {
     return rank_mask(relative_rank(rank, c));
 }
+
+// Side-specialized variants, letting the color-dependent shifts and masks fold into constants
+template <Color::Value::ColorValue c>
+constexpr inline Bitboard pawn_shift(Bitboard bb, int times = 1) {
+    return c == Color::Value::WHITE ? bb << (8 * times) : bb >> (8 * times);
+}
+template <Color::Value::ColorValue c>
+constexpr inline Square pawn_shift(Square sq, int times = 1) {
+    return c == Color::Value::WHITE ? sq + (8 * times) : sq - (8 * times);
+}
+template <Color::Value::ColorValue c>
+constexpr inline Rank relative_rank(Rank rank) {
+    return c == Color::Value::WHITE
+               ? rank
+               : Rank{static_cast<Rank::value_type>(constants::RANK_8.value() - rank.value())};
+}
+template <Color::Value::ColorValue c>
+constexpr inline Bitboard relative_rank_mask(Rank rank) {
+    return rank_mask(relative_rank<c>(rank));
+}
 inline Bitboard non_pawn_piece_type_attacks(PieceType piece_type,
                                             Square square,
                                             Bitboard occupancies = Bitboard{0}) {
@@ -2,8 +2,8 @@
 #define LIBCHESS_MOVE_H
 
 #include <algorithm>
+#include <cassert>
 #include <optional>
-#include <vector>
 
 #include "PieceType.h"
 #include "Square.h"
@@ -123,35 +123,42 @@ class Move {
 
 class MoveList {
    public:
-    using value_type = std::vector<Move>;
-    using iterator = value_type::iterator;
-    using const_iterator = value_type::const_iterator;
+    constexpr static int MAX_SIZE = 256;
+    using value_type = Move[MAX_SIZE];
+    using iterator = Move*;
+    using const_iterator = const Move*;
 
-    MoveList() {
-        values_.reserve(32);
+    // The move storage is deliberately left uninitialized; only the first size() entries are valid
+    MoveList() : size_(0) {
     }
 
     iterator begin() {
-        return values_.begin();
+        return values_;
     }
     iterator end() {
-        return values_.end();
+        return values_ + size_;
+    }
+    const_iterator begin() const {
+        return values_;
+    }
+    const_iterator end() const {
+        return values_ + size_;
     }
     const_iterator cbegin() const {
-        return values_.cbegin();
+        return values_;
     }
     const_iterator cend() const {
-        return values_.cend();
+        return values_ + size_;
     }
 
     void pop_back() {
-        values_.pop_back();
+        --size_;
     }
     void add(Move move) {
-        values_.push_back(move);
+        assert(size_ < MAX_SIZE);
+        values_[size_++] = move;
     }
     void add(const MoveList& move_list) noexcept {
-        values_.reserve(size() + move_list.size());
         for (auto iter = move_list.cbegin(); iter != move_list.cend(); ++iter) {
             add(*iter);
         }
@@ -159,8 +166,7 @@ class MoveList {
     template <class F>
     void sort(F move_evaluator) {
         auto& moves = values_mut_ref();
-        std::vector<int> scores;
-        scores.resize(values_.size());
+        int scores[MAX_SIZE];
         for (int i = 0; i < size(); ++i) {
             scores[i] = move_evaluator(moves[i]);
         }
@@ -181,13 +187,13 @@ class MoveList {
         }
     }
     void clear() noexcept {
-        values_.clear();
+        size_ = 0;
     }
     bool empty() const noexcept {
-        return values_.empty();
+        return size_ == 0;
     }
     int size() const {
-        return values_.size();
+        return size_;
     }
     const value_type& values() const {
         return values_;
@@ -202,7 +208,10 @@ class MoveList {
     }
 
    private:
-    value_type values_;
+    union {
+        value_type values_;
+    };
+    int size_;
 };
 
 inline std::ostream& operator<<(std::ostream& ostream, Move move) {
@@ -0,0 +1,214 @@
+#ifndef LIBCHESS_MOVEPICKER_H
+#define LIBCHESS_MOVEPICKER_H
+
+#include <array>
+#include <optional>
+
+#include "Move.h"
+#include "Position.h"
+
+namespace libchess {
+
+// Yields the moves of a position one at a time, generating each stage only once it is reached:
+// the TT move, captures by MVV-LVA, killers, then quiets by history. When in check, the
+// evasions are generated in a single stage instead. Moves other than the TT move and killers are
+// pseudo-legal, so the caller still has to verify legality.
+class MovePicker {
+   public:
+    using HistoryTable = int[2][64][64];
+
+    explicit MovePicker(const Position& position,
+                        std::optional<Move> tt_move = std::nullopt,
+                        std::array<Move, 2> killers = {},
+                        const HistoryTable* history = nullptr)
+        : position_(position),
+          tt_move_(tt_move),
+          killers_(killers),
+          history_(history),
+          stage_(position.in_check() ? Stage::GENERATE_EVASIONS : Stage::TT_MOVE),
+          index_(0) {
+    }
+
+    std::optional<Move> next() {
+        switch (stage_) {
+            case Stage::TT_MOVE:
+                stage_ = Stage::GENERATE_CAPTURES;
+                if (tt_move_ && position_.is_legal_move(*tt_move_)) {
+                    tt_move_ = typed(*tt_move_);
+                    return tt_move_;
+                }
+                tt_move_ = std::nullopt;
+                [[fallthrough]];
+            case Stage::GENERATE_CAPTURES:
+                generate<Position::GenType::CAPTURES>();
+                for (int i = 0; i < moves_.size(); ++i) {
+                    scores_[i] = mvv_lva(moves_.begin()[i]);
+                }
+                stage_ = Stage::CAPTURES;
+                [[fallthrough]];
+            case Stage::CAPTURES:
+                while (index_ < moves_.size()) {
+                    Move move = pick_best();
+                    if (move != tt_move_) {
+                        return move;
+                    }
+                }
+                stage_ = Stage::KILLER_1;
+                [[fallthrough]];
+            case Stage::KILLER_1:
+                stage_ = Stage::KILLER_2;
+                if (is_valid_killer(0)) {
+                    return killers_[0];
+                }
+                [[fallthrough]];
+            case Stage::KILLER_2:
+                stage_ = Stage::GENERATE_QUIETS;
+                if (is_valid_killer(1)) {
+                    return killers_[1];
+                }
+                [[fallthrough]];
+            case Stage::GENERATE_QUIETS:
+                generate<Position::GenType::QUIETS>();
+                for (int i = 0; i < moves_.size(); ++i) {
+                    scores_[i] = history_score(moves_.begin()[i]);
+                }
+                stage_ = Stage::QUIETS;
+                [[fallthrough]];
+            case Stage::QUIETS:
+                while (index_ < moves_.size()) {
+                    Move move = pick_best();
+                    if (move != tt_move_ && !is_yielded_killer(move)) {
+                        return move;
+                    }
+                }
+                stage_ = Stage::DONE;
+                return std::nullopt;
+            case Stage::GENERATE_EVASIONS:
+                generate<Position::GenType::EVASIONS>();
+                for (int i = 0; i < moves_.size(); ++i) {
+                    Move move = moves_.begin()[i];
+                    if (move == tt_move_) {
+                        scores_[i] = TT_MOVE_SCORE;
+                    } else if (position_.is_capture_move(move)) {
+                        scores_[i] = CAPTURE_SCORE + mvv_lva(move);
+                    } else {
+                        scores_[i] = history_score(move);
+                    }
+                }
+                stage_ = Stage::EVASIONS;
+                [[fallthrough]];
+            case Stage::EVASIONS:
+                if (index_ < moves_.size()) {
+                    return pick_best();
+                }
+                stage_ = Stage::DONE;
+                return std::nullopt;
+            case Stage::DONE:
+            default:
+                return std::nullopt;
+        }
+    }
+
+   private:
+    enum class Stage
+    {
+        TT_MOVE,
+        GENERATE_CAPTURES,
+        CAPTURES,
+        KILLER_1,
+        KILLER_2,
+        GENERATE_QUIETS,
+        QUIETS,
+        GENERATE_EVASIONS,
+        EVASIONS,
+        DONE
+    };
+
+    constexpr static int TT_MOVE_SCORE = 1 << 30;
+    constexpr static int CAPTURE_SCORE = 1 << 28;
+
+    template <Position::GenType gen_type>
+    void generate() {
+        moves_.clear();
+        index_ = 0;
+        if (position_.side_to_move() == constants::WHITE) {
+            position_.generate<Color::Value::WHITE, gen_type>(moves_);
+        } else {
+            position_.generate<Color::Value::BLACK, gen_type>(moves_);
+        }
+    }
+
+    // Selection sort step: swaps the best remaining move to the front of the unyielded range
+    Move pick_best() {
+        Move* moves = moves_.begin();
+        int best = index_;
+        for (int i = index_ + 1; i < moves_.size(); ++i) {
+            if (scores_[i] > scores_[best]) {
+                best = i;
+            }
+        }
+        std::swap(moves[index_], moves[best]);
+        std::swap(scores_[index_], scores_[best]);
+        return moves[index_++];
+    }
+
+    int mvv_lva(Move move) const {
+        auto victim_pt = position_.piece_type_on(move.to_square());
+        int victim_value = victim_pt ? victim_pt->value() : constants::PAWN.value();
+        int attacker_value = position_.piece_type_on(move.from_square())->value();
+        auto promotion_pt = move.promotion_piece_type();
+        int promotion_value = promotion_pt ? promotion_pt->value() : 0;
+        return (victim_value + promotion_value) * 8 - attacker_value;
+    }
+
+    int history_score(Move move) const {
+        if (!history_) {
+            return 0;
+        }
+        return (*history_)[position_.side_to_move().value()][move.from_square().value()]
+                          [move.to_square().value()];
+    }
+
+    bool is_valid_killer(int index) {
+        Move killer = killers_[index];
+        if (killer == tt_move_ || (index == 1 && killer == killers_[0]) ||
+            !position_.is_legal_move(killer)) {
+            return false;
+        }
+        killer = typed(killer);
+        if (position_.is_capture_move(killer)) {
+            return false;
+        }
+        killers_[index] = killer;
+        yielded_killers_[index] = true;
+        return true;
+    }
+
+    bool is_yielded_killer(Move move) const {
+        return (yielded_killers_[0] && move == killers_[0]) ||
+               (yielded_killers_[1] && move == killers_[1]);
+    }
+
+    Move typed(Move move) const {
+        Move::Type move_type = position_.move_type_of(move);
+        auto promotion_pt = move.promotion_piece_type();
+        if (promotion_pt) {
+            return Move{move.from_square(), move.to_square(), *promotion_pt, move_type};
+        }
+        return Move{move.from_square(), move.to_square(), move_type};
+    }
+
+    const Position& position_;
+    std::optional<Move> tt_move_;
+    std::array<Move, 2> killers_;
+    std::array<bool, 2> yielded_killers_{};
+    const HistoryTable* history_;
+    Stage stage_;
+    MoveList moves_;
+    int scores_[MoveList::MAX_SIZE];
+    int index_;
+};
+
+}  // namespace libchess
+
+#endif  // LIBCHESS_MOVEPICKER_H
@@ -0,0 +1,114 @@
+#ifndef LIBCHESS_PAWNHASHTABLE_H
+#define LIBCHESS_PAWNHASHTABLE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Position.h"
+#include "UCIOption.h"
+
+namespace libchess {
+
+// Caches pawn-structure evaluation results of a user-defined type T (passed pawn bitboards,
+// mg/eg scores, ...) by Position::pawn_hash(). It is meant to be owned by one search thread,
+// so nothing is synchronized. Each slot holds one entry and a colliding store overwrites it.
+template <class T>
+class PawnHashTable {
+   public:
+    using hash_type = Position::hash_type;
+
+    constexpr static int DEFAULT_SIZE_MB = 2;
+    constexpr static int MAX_SIZE_MB = 1024;
+
+    explicit PawnHashTable(int size_mb = DEFAULT_SIZE_MB) {
+        resize(size_mb);
+    }
+
+    void resize(int size_mb) {
+        size_mb = std::clamp(size_mb, 1, MAX_SIZE_MB);
+        std::size_t num_slots = 1;
+        while (num_slots * 2 * sizeof(Slot) <= std::size_t(size_mb) * 1024 * 1024) {
+            num_slots *= 2;
+        }
+        slots_ = std::vector<Slot>(num_slots);
+        mask_ = num_slots - 1;
+        size_mb_ = size_mb;
+        reset_counters();
+    }
+    void clear() {
+        std::fill(slots_.begin(), slots_.end(), Slot{});
+        reset_counters();
+    }
+
+    // Returns the cached result for the key, or nullptr on a miss
+    const T* probe(hash_type pawn_hash) {
+        const Slot& slot = slots_[pawn_hash & mask_];
+        if (slot.is_used && slot.key == pawn_hash) {
+            ++hits_;
+            return &slot.value;
+        }
+        ++misses_;
+        return nullptr;
+    }
+    void store(hash_type pawn_hash, const T& value) {
+        slots_[pawn_hash & mask_] = Slot{pawn_hash, value, true};
+    }
+    // Returns the cached result for the position's pawns, computing and storing it on a miss
+    template <class Evaluate>
+    const T& probe_or_evaluate(const Position& pos, Evaluate evaluate) {
+        hash_type pawn_hash = pos.pawn_hash();
+        if (const T* value = probe(pawn_hash)) {
+            return *value;
+        }
+        Slot& slot = slots_[pawn_hash & mask_];
+        slot = Slot{pawn_hash, evaluate(pos), true};
+        return slot.value;
+    }
+
+    std::uint64_t hits() const {
+        return hits_;
+    }
+    std::uint64_t misses() const {
+        return misses_;
+    }
+    // Fraction of probes that hit since the last reset, 0 when there were none
+    double hit_rate() const {
+        std::uint64_t probes = hits_ + misses_;
+        return probes ? double(hits_) / double(probes) : 0.0;
+    }
+    void reset_counters() {
+        hits_ = 0;
+        misses_ = 0;
+    }
+
+    int size_mb() const {
+        return size_mb_;
+    }
+    // A spin option that resizes this table when set. Engines running several threads register
+    // one option whose handler resizes every thread's table instead.
+    UCISpinOption uci_option(const std::string& name = "PawnHash") {
+        return UCISpinOption{name, size_mb_, 1, MAX_SIZE_MB, [this](const int& size_mb) {
+                                 resize(size_mb);
+                             }};
+    }
+
+   private:
+    struct Slot {
+        hash_type key = 0;
+        T value{};
+        bool is_used = false;
+    };
+
+    std::vector<Slot> slots_;
+    std::size_t mask_ = 0;
+    int size_mb_ = 0;
+    std::uint64_t hits_ = 0;
+    std::uint64_t misses_ = 0;
+};
+
+}  // namespace libchess
+
+#endif  // LIBCHESS_PAWNHASHTABLE_H
@@ -0,0 +1,195 @@
+#ifndef LIBCHESS_POLYGLOTBOOK_H
+#define LIBCHESS_POLYGLOTBOOK_H
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Move.h"
+#include "Position.h"
+
+namespace libchess {
+
+namespace polyglot {
+
+constexpr std::size_t ENTRY_SIZE = 16;
+
+// Polyglot files are big-endian regardless of the platform
+template <class T>
+inline T read_big_endian(const unsigned char* bytes) {
+    T value = 0;
+    for (std::size_t i = 0; i < sizeof(T); ++i) {
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
+
+// Decodes a Polyglot move (to file/rank, from file/rank, promotion from the low bits up) in the
+// given position. Castling is encoded as the king capturing its own rook, e1h1 for e1g1 and so on.
+inline Move decode_move(std::uint16_t book_move, const Position& pos) {
+    Square to_square = Square{book_move & 0x3f};
+    Square from_square = Square{(book_move >> 6) & 0x3f};
+    // Knight to queen are numbered 1 to 4, as in PieceType
+    int promotion = (book_move >> 12) & 7;
+    if (promotion) {
+        return Move{from_square, to_square, PieceType{promotion}};
+    }
+    if (pos.piece_type_on(from_square) == constants::KING) {
+        if (from_square == constants::E1 && to_square == constants::H1) {
+            return Move{constants::E1, constants::G1};
+        } else if (from_square == constants::E1 && to_square == constants::A1) {
+            return Move{constants::E1, constants::C1};
+        } else if (from_square == constants::E8 && to_square == constants::H8) {
+            return Move{constants::E8, constants::G8};
+        } else if (from_square == constants::E8 && to_square == constants::A8) {
+            return Move{constants::E8, constants::C8};
+        }
+    }
+    return Move{from_square, to_square};
+}
+
+// The inverse of decode_move for a move legal in the given position
+inline std::uint16_t encode_move(Move move, const Position& pos) {
+    Square from_square = move.from_square();
+    Square to_square = move.to_square();
+    if (pos.move_type_of(move) == Move::Type::CASTLING) {
+        to_square = to_square > from_square ? Square{from_square + 3} : Square{from_square - 4};
+    }
+    auto promotion_pt = move.promotion_piece_type();
+    int promotion = promotion_pt ? promotion_pt->value() : 0;
+    return std::uint16_t(to_square.value() | (from_square.value() << 6) | (promotion << 12));
+}
+
+}  // namespace polyglot
+
+// A read-only Polyglot opening book. The file is memory-mapped rather than read, so opening is
+// cheap regardless of the book size and only the pages touched by the binary search are loaded.
+class PolyglotBook {
+   public:
+    struct BookMove {
+        Move move;
+        int weight;
+    };
+
+    static std::optional<PolyglotBook> open(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return std::nullopt;
+        }
+        struct stat file_stat;
+        if (::fstat(fd, &file_stat) != 0 || file_stat.st_size % polyglot::ENTRY_SIZE != 0) {
+            ::close(fd);
+            return std::nullopt;
+        }
+        std::size_t size = file_stat.st_size;
+        void* data = nullptr;
+        if (size > 0) {
+            data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+        if (data == MAP_FAILED) {
+            return std::nullopt;
+        }
+        return PolyglotBook{static_cast<const unsigned char*>(data), size};
+    }
+
+    PolyglotBook(const PolyglotBook&) = delete;
+    PolyglotBook& operator=(const PolyglotBook&) = delete;
+    PolyglotBook(PolyglotBook&& other) noexcept
+        : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)) {
+    }
+    PolyglotBook& operator=(PolyglotBook&& other) noexcept {
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+        return *this;
+    }
+    ~PolyglotBook() {
+        if (data_) {
+            ::munmap(const_cast<unsigned char*>(data_), size_);
+        }
+    }
+
+    std::size_t num_entries() const {
+        return size_ / polyglot::ENTRY_SIZE;
+    }
+
+    // All legal book moves for the position, in file order (by convention heaviest first)
+    std::vector<BookMove> probe(const Position& pos) const {
+        std::vector<BookMove> book_moves;
+        Position::hash_type hash = pos.hash();
+        for (std::size_t i = lower_bound(hash); i < num_entries() && key_at(i) == hash; ++i) {
+            const unsigned char* entry = entry_at(i);
+            Move move = polyglot::decode_move(polyglot::read_big_endian<std::uint16_t>(entry + 8),
+                                              pos);
+            // Guards against key collisions and corrupt entries
+            if (pos.is_legal_move(move)) {
+                book_moves.push_back(
+                    BookMove{move, polyglot::read_big_endian<std::uint16_t>(entry + 10)});
+            }
+        }
+        return book_moves;
+    }
+
+    // Picks a book move with probability proportional to its weight, given a uniform random value
+    std::optional<Move> weighted_move(const Position& pos, std::uint64_t random_value) const {
+        std::vector<BookMove> book_moves = probe(pos);
+        if (book_moves.empty()) {
+            return std::nullopt;
+        }
+        std::uint64_t total_weight = 0;
+        for (const BookMove& book_move : book_moves) {
+            total_weight += book_move.weight;
+        }
+        if (total_weight == 0) {
+            return book_moves.front().move;
+        }
+        std::uint64_t target = random_value % total_weight;
+        for (const BookMove& book_move : book_moves) {
+            if (target < std::uint64_t(book_move.weight)) {
+                return book_move.move;
+            }
+            target -= book_move.weight;
+        }
+        return book_moves.back().move;
+    }
+
+   private:
+    PolyglotBook(const unsigned char* data, std::size_t size) : data_(data), size_(size) {
+    }
+
+    const unsigned char* entry_at(std::size_t index) const {
+        return data_ + index * polyglot::ENTRY_SIZE;
+    }
+    Position::hash_type key_at(std::size_t index) const {
+        return polyglot::read_big_endian<std::uint64_t>(entry_at(index));
+    }
+    // Index of the first entry whose key is not less than hash
+    std::size_t lower_bound(Position::hash_type hash) const {
+        std::size_t low = 0;
+        std::size_t high = num_entries();
+        while (low < high) {
+            std::size_t mid = low + (high - low) / 2;
+            if (key_at(mid) < hash) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return low;
+    }
+
+    const unsigned char* data_;
+    std::size_t size_;
+};
+
+}  // namespace libchess
+
+#endif  // LIBCHESS_POLYGLOTBOOK_H
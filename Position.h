@@ -1,11 +1,15 @@
 #ifndef LIBCHESS_POSITION_H
 #define LIBCHESS_POSITION_H
 
+#include <algorithm>
+#include <array>
+#include <cassert>
 #include <cctype>
 #include <optional>
 #include <sstream>
 #include <string>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 #include "Bitboard.h"
@@ -16,6 +20,7 @@
 #include "Piece.h"
 #include "PieceType.h"
 #include "Square.h"
+#include "internal/Cuckoo.h"
 #include "internal/Zobrist.h"
 
 namespace libchess {
@@ -27,14 +32,41 @@ static std::string STARTPOS_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w
 }  // namespace constants
 
 class Position {
+    friend class CompactPosition;
+
    private:
     Position() : side_to_move_(constants::WHITE), ply_(0) {
+        std::fill(std::begin(board_), std::end(board_), EMPTY_SQUARE);
     }
 
    public:
     explicit Position(const std::string& fen_str) : Position() {
-        *this = *Position::from_fen(fen_str);
+        *this = std::move(*Position::from_fen(fen_str));
+    }
+    // A copied vector only has capacity for its size, so copies reserve search headroom again
+    // rather than reallocating on their first make_move. Only the states up to the current ply are
+    // copied.
+    Position(const Position& other) : Position() {
+        *this = other;
+    }
+    Position& operator=(const Position& other) {
+        if (this == &other) {
+            return *this;
+        }
+        std::copy(std::begin(other.piece_type_bb_), std::end(other.piece_type_bb_),
+                  std::begin(piece_type_bb_));
+        std::copy(std::begin(other.color_bb_), std::end(other.color_bb_), std::begin(color_bb_));
+        std::copy(std::begin(other.board_), std::end(other.board_), std::begin(board_));
+        side_to_move_ = other.side_to_move_;
+        fullmoves_ = other.fullmoves_;
+        ply_ = other.ply_;
+        reserve_history();
+        history_.assign(other.history_.begin(), other.history_.begin() + other.ply_ + 1);
+        start_fen_ = other.start_fen_;
+        return *this;
     }
+    Position(Position&&) = default;
+    Position& operator=(Position&&) = default;
     using hash_type = std::uint64_t;
 
     enum class GameState
@@ -46,6 +78,20 @@ class Position {
         FIFTY_MOVES
     };
 
+    // Values behind the incrementally kept non-pawn material, and game phase weights
+    constexpr static std::array<int, 6> MATERIAL_VALUES = {100, 320, 330, 500, 900, 0};
+    constexpr static int PHASE_WEIGHTS[6] = {0, 1, 1, 2, 4, 0};
+    constexpr static int MAX_PHASE = 24;
+
+    enum class GenType
+    {
+        CAPTURES,
+        QUIETS,
+        EVASIONS,
+        ALL,
+        LEGAL
+    };
+
     // Getters
     Bitboard piece_type_bb(PieceType piece_type) const;
     Bitboard piece_type_bb(PieceType piece_type, Color color) const;
@@ -60,12 +106,17 @@ class Position {
     std::optional<Color> color_of(Square square) const;
     std::optional<Piece> piece_on(Square square) const;
     hash_type hash() const;
+    hash_type pawn_hash() const;
+    hash_type material_hash() const;
+    int non_pawn_material(Color color) const;
+    int phase() const;
     Square king_square(Color color) const;
     int halfmoves() const;
     int fullmoves() const;
     bool in_check() const;
     bool is_repeat(int times = 1) const;
     int repeat_count() const;
+    bool has_upcoming_repetition(int search_ply) const;
     const std::string& start_fen() const;
     GameState game_state() const;
 
@@ -73,10 +124,13 @@ class Position {
     Move::Type move_type_of(Move move) const;
     bool is_capture_move(Move move) const;
     bool is_promotion_move(Move move) const;
+    bool is_pseudo_legal(Move move) const;
     bool is_legal_move(Move move) const;
     bool is_legal_generated_move(Move move) const;
     void unmake_move();
     void make_move(Move move);
+    void unmake_generated_move();
+    void make_generated_move(Move move);
     void make_null_move();
 
     // Attacks
@@ -87,6 +141,10 @@ class Position {
     Bitboard attackers_to(Square square, Bitboard occupancy, Color c) const;
     Bitboard attacks_of_piece_on(Square square) const;
     Bitboard pinned_pieces_of(Color c) const;
+    Bitboard checkers() const;
+    Bitboard blockers_for_king(Color c) const;
+    Bitboard pinners(Color c) const;
+    Bitboard check_squares(PieceType piece_type) const;
 
     // Move Generation
     void generate_quiet_promotions(MoveList& move_list, Color stm) const;
@@ -107,12 +165,49 @@ class Position {
     void generate_checker_capture_moves(MoveList& move_list, Color stm) const;
     void generate_quiet_moves(MoveList& move_list, Color stm) const;
     void generate_capture_moves(MoveList& move_list, Color stm) const;
+    void generate_legal_moves(MoveList& move_list, Color stm) const;
     MoveList check_evasion_move_list(Color stm) const;
     MoveList pseudo_legal_move_list(Color stm) const;
     MoveList legal_move_list(Color stm) const;
     MoveList check_evasion_move_list() const;
     MoveList pseudo_legal_move_list() const;
     MoveList legal_move_list() const;
+    int legal_move_count(Color stm) const;
+    int legal_move_count() const;
+
+    // Side-specialized Move Generation
+    template <Color::Value::ColorValue c, GenType gen_type>
+    void generate(MoveList& move_list) const;
+    template <Color::Value::ColorValue c>
+    void generate_quiet_promotions(MoveList& move_list) const;
+    template <Color::Value::ColorValue c>
+    void generate_capture_promotions(MoveList& move_list) const;
+    template <Color::Value::ColorValue c>
+    void generate_promotions(MoveList& move_list) const;
+    template <Color::Value::ColorValue c>
+    void generate_pawn_quiets(MoveList& move_list) const;
+    template <Color::Value::ColorValue c>
+    void generate_pawn_captures(MoveList& move_list) const;
+    template <Color::Value::ColorValue c>
+    void generate_pawn_moves(MoveList& move_list) const;
+    template <Color::Value::ColorValue c>
+    bool can_castle(int side) const;
+    template <Color::Value::ColorValue c>
+    void generate_castling(MoveList& move_list) const;
+    template <Color::Value::ColorValue c>
+    void generate_checker_block_moves(MoveList& move_list) const;
+    template <Color::Value::ColorValue c>
+    void generate_checker_capture_moves(MoveList& move_list) const;
+    template <Color::Value::ColorValue c>
+    void generate_check_evasions(MoveList& move_list) const;
+    template <Color::Value::ColorValue c>
+    void generate_quiet_moves(MoveList& move_list) const;
+    template <Color::Value::ColorValue c>
+    void generate_capture_moves(MoveList& move_list) const;
+    template <Color::Value::ColorValue c>
+    void generate_legal_moves(MoveList& move_list) const;
+    template <Color::Value::ColorValue c>
+    int count_legal_moves() const;
 
     // Utilities
     void display_raw(std::ostream& ostream = std::cout) const;
@@ -121,8 +216,9 @@ class Position {
     std::string uci_line() const;
     void vflip();
     std::optional<Move> smallest_capture_move_to(Square square) const;
-    int see_to(Square square, std::array<int, 6> piece_values);
-    int see_for(Move move, std::array<int, 6> piece_values);
+    int see_to(Square square, std::array<int, 6> piece_values) const;
+    int see_for(Move move, std::array<int, 6> piece_values) const;
+    bool see_ge(Move move, int threshold, std::array<int, 6> piece_values = MATERIAL_VALUES) const;
     static std::optional<Position> from_fen(const std::string& fen);
     static std::optional<Position> from_uci_position_line(const std::string& line);
 
@@ -153,7 +249,7 @@ class Position {
     }
 
 
-    hash_type calculate_hash() {
+    hash_type calculate_hash() const {
         hash_type hash_value = 0;
         for (Color c : constants::COLORS) {
             for (PieceType pt : constants::PIECE_TYPES) {
@@ -179,6 +275,32 @@ class Position {
         return hash_value;
     }
 
+    hash_type calculate_pawn_hash() const {
+        hash_type hash_value = 0;
+        for (Color c : constants::COLORS) {
+            Bitboard bb = piece_type_bb(constants::PAWN, c);
+            while (bb) {
+                hash_value ^= zobrist::piece_square_key(bb.forward_bitscan(), constants::PAWN, c);
+                bb.forward_popbit();
+            }
+        }
+        return hash_value;
+    }
+
+    // The material signature keys the n-th piece of a kind with that kind's key on square n
+    hash_type calculate_material_hash() const {
+        hash_type hash_value = 0;
+        for (Color c : constants::COLORS) {
+            for (PieceType pt : constants::PIECE_TYPES) {
+                int count = piece_type_bb(pt, c).popcount();
+                for (int i = 0; i < count; ++i) {
+                    hash_value ^= zobrist::piece_square_key(Square{i}, pt, c);
+                }
+            }
+        }
+        return hash_value;
+    }
+
    protected:
     // clang-format off
     constexpr static int castling_spoilers[64] = {
@@ -193,15 +315,77 @@ class Position {
     };
     // clang-format on
 
+    // States reserved beyond the current ply, enough for a search from it to never reallocate
+    constexpr static int HISTORY_HEADROOM = 256;
+
+    // Mailbox entries use the Piece encoding (type | color << 3); an empty square has no type
+    constexpr static std::uint8_t EMPTY_SQUARE = 7;
+
+    // Optional fields are stored with sentinel values. Besides the 24 bytes of position data, a
+    // State carries the pawn and material keys and the check info that legal move generation reads
+    // every ply, for 88 bytes in all. Anything cheap to derive on demand is left out.
     struct State {
-        CastlingRights castling_rights_;
-        std::optional<Square> enpassant_square_;
-        std::optional<Move> previous_move_;
-        std::optional<PieceType> captured_pt_;
-        Move::Type move_type_ = Move::Type::NONE;
+        constexpr static std::uint8_t NO_SQUARE = 64;
+        constexpr static std::uint8_t NO_PIECE_TYPE = 7;
+
         hash_type hash_ = 0;
-        int halfmoves_ = 0;
+        hash_type pawn_hash_ = 0;
+        hash_type material_hash_ = 0;
+        // Check info, recomputed once per ply by set_check_info. Blockers and pinners are indexed
+        // by the color of the king they concern
+        Bitboard checkers_;
+        Bitboard blockers_[2];
+        Bitboard pinners_[2];
+        Move previous_move_{};
+        std::uint16_t halfmoves_ = 0;
+        // Plies since the last null move or the root, so repetition scans never cross a null move
+        std::uint16_t plies_from_null_ = 0;
+        std::int16_t non_pawn_material_[2] = {0, 0};
+        std::uint8_t castling_rights_ = 0;
+        std::uint8_t enpassant_square_ = NO_SQUARE;
+        std::uint8_t captured_pt_ = NO_PIECE_TYPE;
+        std::uint8_t moved_pt_ = NO_PIECE_TYPE;
+        std::uint8_t phase_ = 0;
+        std::uint8_t king_square_[2] = {NO_SQUARE, NO_SQUARE};
+        Move::Type move_type_ = Move::Type::NONE;
+
+        CastlingRights castling_rights() const {
+            return CastlingRights{castling_rights_};
+        }
+        void set_castling_rights(CastlingRights castling_rights) {
+            castling_rights_ = castling_rights.value();
+        }
+        // How many earlier states a repetition of this one can be found in
+        int repetition_window() const {
+            return std::min(halfmoves_, plies_from_null_);
+        }
+        std::optional<Square> enpassant_square() const {
+            if (enpassant_square_ == NO_SQUARE) {
+                return std::nullopt;
+            }
+            return Square{enpassant_square_};
+        }
+        void set_enpassant_square(std::optional<Square> square) {
+            enpassant_square_ = square ? square->value() : NO_SQUARE;
+        }
+        // A null move leaves the previous move as the A1A1 sentinel, which is never a real move
+        std::optional<Move> previous_move() const {
+            if (previous_move_.value() == 0) {
+                return std::nullopt;
+            }
+            return previous_move_;
+        }
+        std::optional<PieceType> captured_pt() const {
+            if (captured_pt_ == NO_PIECE_TYPE) {
+                return std::nullopt;
+            }
+            return PieceType{captured_pt_};
+        }
+        void set_captured_pt(std::optional<PieceType> piece_type) {
+            captured_pt_ = piece_type ? piece_type->value() : NO_PIECE_TYPE;
+        }
     };
+    static_assert(sizeof(State) <= 88);
 
     int ply() const {
         return ply_;
@@ -226,16 +410,76 @@ class Position {
         Bitboard square_bb = Bitboard{square};
         piece_type_bb_[piece_type.value()] |= square_bb;
         color_bb_[color.value()] |= square_bb;
+        board_[square.value()] = piece_type.value() | (color.value() << 3);
     }
     void remove_piece(Square square, PieceType piece_type, Color color) {
         Bitboard square_bb = Bitboard{square};
         piece_type_bb_[piece_type.value()] &= ~square_bb;
         color_bb_[color.value()] &= ~square_bb;
+        board_[square.value()] = EMPTY_SQUARE;
     }
     void move_piece(Square from_square, Square to_square, PieceType piece_type, Color color) {
         Bitboard from_to_sqs_bb = Bitboard{from_square} ^ Bitboard { to_square };
         piece_type_bb_[piece_type.value()] ^= from_to_sqs_bb;
         color_bb_[color.value()] ^= from_to_sqs_bb;
+        board_[to_square.value()] = board_[from_square.value()];
+        board_[from_square.value()] = EMPTY_SQUARE;
+    }
+    void reserve_history() {
+        history_.reserve(ply_ + 1 + HISTORY_HEADROOM);
+    }
+    // The history is a stack indexed by ply that never shrinks, so revisiting a depth reuses its
+    // entry and only a new maximum depth beyond the reserved capacity can touch the allocator.
+    // Positions that were never reserved (e.g. from CompactPosition::to_position) reserve lazily.
+    void push_state() {
+        ++ply_;
+        if (ply_ == static_cast<int>(history_.size())) {
+            if (history_.size() == history_.capacity()) {
+                history_.reserve(std::max(2 * history_.size(), history_.size() + HISTORY_HEADROOM));
+            }
+            history_.emplace_back();
+        } else {
+            history_[ply_] = State{};
+        }
+    }
+    void make_typed_move(Move move, Move::Type move_type);
+    int see_exchange(Move move, const std::array<int, 6>& piece_values) const;
+    Bitboard slider_blockers(Bitboard sliders, Square square, Bitboard& pinners) const;
+    void set_check_info(State& curr_state) const;
+    // Recomputes every key and material count of the current state from the board
+    void reset_state_keys() {
+        State& curr_state = state_mut_ref();
+        curr_state.hash_ = calculate_hash();
+        curr_state.pawn_hash_ = calculate_pawn_hash();
+        curr_state.material_hash_ = calculate_material_hash();
+        curr_state.phase_ = 0;
+        for (Color c : constants::COLORS) {
+            curr_state.non_pawn_material_[c.value()] = 0;
+            for (PieceType pt = constants::KNIGHT; pt <= constants::QUEEN; ++pt) {
+                int count = piece_type_bb(pt, c).popcount();
+                curr_state.non_pawn_material_[c.value()] += count * MATERIAL_VALUES[pt.value()];
+                curr_state.phase_ += count * PHASE_WEIGHTS[pt.value()];
+            }
+        }
+        set_check_info(curr_state);
+    }
+    void remove_material(State& next_state, Square square, PieceType piece_type, Color color) {
+        if (piece_type == constants::PAWN) {
+            next_state.pawn_hash_ ^= zobrist::piece_square_key(square, piece_type, color);
+        }
+        // Called after the board update, so the count no longer includes the removed piece
+        int count = piece_type_bb(piece_type, color).popcount();
+        next_state.material_hash_ ^= zobrist::piece_square_key(Square{count}, piece_type, color);
+        next_state.non_pawn_material_[color.value()] -=
+            piece_type == constants::PAWN ? 0 : MATERIAL_VALUES[piece_type.value()];
+        next_state.phase_ -= PHASE_WEIGHTS[piece_type.value()];
+    }
+    void add_material(State& next_state, PieceType piece_type, Color color) {
+        int count = piece_type_bb(piece_type, color).popcount();
+        next_state.material_hash_ ^=
+            zobrist::piece_square_key(Square{count - 1}, piece_type, color);
+        next_state.non_pawn_material_[color.value()] += MATERIAL_VALUES[piece_type.value()];
+        next_state.phase_ += PHASE_WEIGHTS[piece_type.value()];
     }
     void reverse_side_to_move() {
         side_to_move_ = !side_to_move_;
@@ -244,12 +488,14 @@ class Position {
    private:
     Bitboard piece_type_bb_[6];
     Bitboard color_bb_[2];
+    std::uint8_t board_[64];
     Color side_to_move_;
     int fullmoves_;
     int ply_;
     std::vector<State> history_;
 
-    std::string start_fen_;
+    // Empty for positions converted from a CompactPosition until start_fen() derives it
+    mutable std::string start_fen_;
 };
 
 }  // namespace libchess
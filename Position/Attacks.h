@@ -4,6 +4,9 @@
 namespace libchess {
 
 inline Bitboard Position::checkers_to(Color c) const {
+    if (c == side_to_move()) {
+        return state().checkers_;
+    }
     return attackers_to(king_square(c), !c);
 }
 
@@ -46,21 +49,93 @@ inline Bitboard Position::attacks_of_piece_on(libchess::Square square) const {
 }
 
 inline Bitboard Position::pinned_pieces_of(Color c) const {
-    Bitboard pinned_bb;
-    Square king_sq = king_square(c);
-    Bitboard pinners_bb = ((piece_type_bb(constants::QUEEN) | piece_type_bb(constants::ROOK)) &
-                           color_bb(!c) & lookups::rook_attacks(king_sq)) |
-                          ((piece_type_bb(constants::QUEEN) | piece_type_bb(constants::BISHOP)) &
-                           color_bb(!c) & lookups::bishop_attacks(king_sq));
-    while (pinners_bb) {
-        Square sq = pinners_bb.forward_bitscan();
-        pinners_bb.forward_popbit();
-        Bitboard bb = lookups::intervening(sq, king_sq) & occupancy_bb();
-        if (bb.popcount() == 1) {
-            pinned_bb ^= bb & color_bb(c);
+    return state().blockers_[c.value()] & color_bb(c);
+}
+
+inline Bitboard Position::checkers() const {
+    return state().checkers_;
+}
+
+inline Bitboard Position::blockers_for_king(Color c) const {
+    return state().blockers_[c.value()];
+}
+
+inline Bitboard Position::pinners(Color c) const {
+    return state().pinners_[c.value()];
+}
+
+// Squares from which a piece of the side to move would give check. These are cheap to derive
+// from the enemy king square, so they are computed on demand rather than kept per ply.
+inline Bitboard Position::check_squares(PieceType piece_type) const {
+    Color stm = side_to_move();
+    std::uint8_t enemy_king_square = state().king_square_[(!stm).value()];
+    if (enemy_king_square == State::NO_SQUARE) {
+        return Bitboard{};
+    }
+    Square enemy_king_sq = Square{enemy_king_square};
+    switch (piece_type.value()) {
+        case PieceType::Value::PAWN:
+            return lookups::pawn_attacks(enemy_king_sq, !stm);
+        case PieceType::Value::KNIGHT:
+            return lookups::knight_attacks(enemy_king_sq);
+        case PieceType::Value::BISHOP:
+            return lookups::bishop_attacks(enemy_king_sq, occupancy_bb());
+        case PieceType::Value::ROOK:
+            return lookups::rook_attacks(enemy_king_sq, occupancy_bb());
+        case PieceType::Value::QUEEN:
+            return lookups::queen_attacks(enemy_king_sq, occupancy_bb());
+        default:
+            return Bitboard{};
+    }
+}
+
+// Returns the pieces of either color that alone stand between a slider in sliders and the square,
+// and sets pinners to the sliders whose blocker has the same color as the piece on the square
+inline Bitboard Position::slider_blockers(Bitboard sliders, Square square, Bitboard& pinners) const {
+    Bitboard blockers;
+    pinners = Bitboard{};
+    Bitboard snipers =
+        ((piece_type_bb(constants::QUEEN) | piece_type_bb(constants::ROOK)) &
+         lookups::rook_attacks(square)) |
+        ((piece_type_bb(constants::QUEEN) | piece_type_bb(constants::BISHOP)) &
+         lookups::bishop_attacks(square));
+    snipers &= sliders;
+    Bitboard occupancy = occupancy_bb();
+    Color color = *color_of(square);
+    while (snipers) {
+        Square sniper_sq = snipers.forward_bitscan();
+        snipers.forward_popbit();
+        Bitboard bb = lookups::intervening(sniper_sq, square) & occupancy;
+        if (bb && bb.popcount() == 1) {
+            blockers |= bb;
+            if (bb & color_bb(color)) {
+                pinners |= Bitboard{sniper_sq};
+            }
         }
     }
-    return pinned_bb;
+    return blockers;
+}
+
+inline void Position::set_check_info(State& curr_state) const {
+    for (Color c : constants::COLORS) {
+        Bitboard king_bb = piece_type_bb(constants::KING, c);
+        curr_state.king_square_[c.value()] = king_bb ? king_bb.forward_bitscan().value()
+                                                     : State::NO_SQUARE;
+    }
+    // Positions without both kings (e.g. during setup) have no meaningful check info
+    if (curr_state.king_square_[0] == State::NO_SQUARE ||
+        curr_state.king_square_[1] == State::NO_SQUARE) {
+        return;
+    }
+
+    Color stm = side_to_move();
+    Square king_sq = Square{curr_state.king_square_[stm.value()]};
+    curr_state.checkers_ = attackers_to(king_sq, !stm);
+    for (Color c : constants::COLORS) {
+        curr_state.blockers_[c.value()] =
+            slider_blockers(color_bb(!c), Square{curr_state.king_square_[c.value()]},
+                            curr_state.pinners_[c.value()]);
+    }
 }
 
 }  // namespace libchess
@@ -24,11 +24,11 @@ inline Color Position::side_to_move() const {
 }
 
 inline CastlingRights Position::castling_rights() const {
-    return history_[ply_].castling_rights_;
+    return history_[ply_].castling_rights();
 }
 
 inline std::optional<Square> Position::enpassant_square() const {
-    return history_[ply_].enpassant_square_;
+    return history_[ply_].enpassant_square();
 }
 
 inline int Position::halfmoves() const {
@@ -40,52 +40,75 @@ inline int Position::fullmoves() const {
 }
 
 inline std::optional<Move> Position::previous_move() const {
-    return history_[ply_].previous_move_;
+    return history_[ply_].previous_move();
 }
 
 inline std::optional<PieceType> Position::previously_captured_piece() const {
-    return history_[ply_].captured_pt_;
+    return history_[ply_].captured_pt();
 }
 
 inline Position::hash_type Position::hash() const {
     return history_[ply_].hash_;
 }
 
+inline Position::hash_type Position::pawn_hash() const {
+    return history_[ply_].pawn_hash_;
+}
+
+inline Position::hash_type Position::material_hash() const {
+    return history_[ply_].material_hash_;
+}
+
+inline int Position::non_pawn_material(Color color) const {
+    return history_[ply_].non_pawn_material_[color.value()];
+}
+
+inline int Position::phase() const {
+    return std::min(int(history_[ply_].phase_), MAX_PHASE);
+}
+
 inline Square Position::king_square(Color color) const {
-    return piece_type_bb(constants::KING, color).forward_bitscan();
+    return Square{state().king_square_[color.value()]};
 }
 
 inline std::optional<PieceType> Position::piece_type_on(Square square) const {
-    for (PieceType piece_type : constants::PIECE_TYPES) {
-        if (piece_type_bb(piece_type) & Bitboard{square}) {
-            return piece_type;
-        }
+    int piece_value = board_[square.value()];
+    if (piece_value == EMPTY_SQUARE) {
+        return std::nullopt;
     }
-    return std::nullopt;
+    return PieceType{piece_value & 7};
 }
 
 inline std::optional<Color> Position::color_of(Square square) const {
-    for (Color c : constants::COLORS) {
-        if (color_bb(c) & Bitboard{square}) {
-            return c;
-        }
+    int piece_value = board_[square.value()];
+    if (piece_value == EMPTY_SQUARE) {
+        return std::nullopt;
     }
-    return std::nullopt;
+    return Color{piece_value >> 3};
 }
 
 inline std::optional<Piece> Position::piece_on(Square square) const {
-    return Piece::from(piece_type_on(square), color_of(square));
+    int piece_value = board_[square.value()];
+    if (piece_value == EMPTY_SQUARE) {
+        return std::nullopt;
+    }
+    return Piece{PieceType{piece_value & 7}, Color{piece_value >> 3}};
 }
 
 inline bool Position::in_check() const {
-    return checkers_to(side_to_move()) != 0;
+    return state().checkers_ != 0;
 }
 
+// Repetitions are searched for among the states since the last irreversible or null move. A
+// position can't recur within two plies, so each repetition takes at least four of them.
 inline bool Position::is_repeat(int times) const {
+    int window = state().repetition_window();
+    if (window < 4 * times) {
+        return false;
+    }
     hash_type curr_hash = hash();
-    int num_keys = std::max(0, ply() - halfmoves());
     int count = 0;
-    for (int i = ply() - 2; i >= num_keys; i -= 2) {
+    for (int i = ply() - 4; i >= ply() - window; i -= 2) {
         if (state(i).hash_ == curr_hash) {
             ++count;
             if (count >= times) {
@@ -98,9 +121,8 @@ inline bool Position::is_repeat(int times) const {
 
 inline int Position::repeat_count() const {
     hash_type curr_hash = hash();
-    int num_keys = std::max(0, ply() - halfmoves());
     int count = 0;
-    for (int i = ply() - 2; i >= num_keys; i -= 2) {
+    for (int i = ply() - 4; i >= ply() - state().repetition_window(); i -= 2) {
         if (state(i).hash_ == curr_hash) {
             ++count;
         }
@@ -108,7 +130,60 @@ inline int Position::repeat_count() const {
     return count;
 }
 
+// Whether the side to move has a reversible move reaching a position from the history, i.e. can
+// force a repetition in one move. Each earlier position with the same side to move is looked up in
+// the cuckoo tables by its hash difference rather than by generating moves. search_ply is the
+// distance from the search root: cycles entirely before the root only count if the earlier
+// position already occurred twice, as a draw must then be a real threefold repetition.
+//
+// The scan makes one table lookup per earlier position, O(window / 2). Only a hit with a cycle at or
+// before the root also walks that position's own window to find an earlier occurrence, so the
+// quadratic worst case is confined to the first plies of a search.
+inline bool Position::has_upcoming_repetition(int search_ply) const {
+    int end = state().repetition_window();
+    if (end < 3) {
+        return false;
+    }
+    hash_type curr_hash = hash();
+    Bitboard occupancy = occupancy_bb();
+    for (int i = 3; i <= end; i += 2) {
+        const State& prev_state = state(ply() - i);
+        const Move* move = cuckoo::lookup(curr_hash ^ prev_state.hash_);
+        if (!move) {
+            continue;
+        }
+        Square from_square = move->from_square();
+        Square to_square = move->to_square();
+        if (lookups::intervening(from_square, to_square) & occupancy) {
+            continue;
+        }
+        if (search_ply > i) {
+            return true;
+        }
+        // The table holds a single direction per square pair, so find which end the piece is on.
+        // It must belong to the side to move, otherwise the move led to the current position.
+        Square piece_square = piece_on(from_square) ? from_square : to_square;
+        if (color_of(piece_square) != side_to_move()) {
+            continue;
+        }
+        int earliest = ply() - i - prev_state.repetition_window();
+        for (int j = ply() - i - 4; j >= earliest; j -= 2) {
+            if (state(j).hash_ == prev_state.hash_) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
 inline const std::string& Position::start_fen() const {
+    if (start_fen_.empty()) {
+        Position root = *this;
+        while (root.ply() > 0) {
+            root.unmake_move();
+        }
+        start_fen_ = root.fen();
+    }
     return start_fen_;
 }
 
@@ -142,85 +217,115 @@ inline bool Position::is_legal_generated_move(Move move) const {
                !(lookups::bishop_attacks(king_sq, post_ep_occupancy) & color_bb(!c) &
                  ((piece_type_bb(constants::QUEEN) | piece_type_bb(constants::BISHOP))));
     } else if (from == king_sq) {
+        // The king is lifted off the board so that it cannot retreat along a checking slider's line
         return move.type() == Move::Type::CASTLING ||
-               !(attackers_to(move.to_square()) & color_bb(!c));
+               !(attackers_to(move.to_square(), occupancy_bb() ^ Bitboard{from}) & color_bb(!c));
     } else {
         return !(pinned_pieces_of(c) & Bitboard{from}) ||
                (Bitboard{move.to_square()} & lookups::full_ray(king_sq, from));
     }
 }
 
-inline bool Position::is_legal_move(Move move) const {
+inline bool Position::is_pseudo_legal(Move move) const {
+    Color c = side_to_move();
     Square from_sq = move.from_square();
+    Square to_sq = move.to_square();
     auto piece_opt = piece_on(from_sq);
-    if (!piece_opt) {
+    if (!piece_opt || piece_opt->color() != c) {
         return false;
     }
-
-    Piece piece = *piece_opt;
-    Color c = piece.color();
-    if (c != side_to_move()) {
+    Bitboard to_sq_bb{to_sq};
+    if (color_bb(c) & to_sq_bb) {
         return false;
     }
 
-    Square to_sq = move.to_square();
-    if (color_of(to_sq) == c) {
+    PieceType pt = piece_opt->type();
+    Bitboard occupancy = occupancy_bb();
+    bool is_capture = bool(to_sq_bb & color_bb(!c));
+    auto promotion_pt = move.promotion_piece_type();
+    Move::Type move_type;
+    if (pt == constants::PAWN) {
+        bool is_promotion = lookups::relative_rank(to_sq.rank(), c) == constants::RANK_8;
+        if (is_promotion != bool(promotion_pt)) {
+            return false;
+        }
+        auto ep_sq = enpassant_square();
+        if (to_sq == lookups::pawn_shift(from_sq, c) && !is_capture) {
+            move_type = is_promotion ? Move::Type::PROMOTION : Move::Type::NORMAL;
+        } else if (lookups::relative_rank(from_sq.rank(), c) == constants::RANK_2 &&
+                   to_sq == lookups::pawn_shift(from_sq, c, 2) &&
+                   !(occupancy & (to_sq_bb | lookups::pawn_shift(to_sq_bb, !c)))) {
+            move_type = Move::Type::DOUBLE_PUSH;
+        } else if (to_sq_bb & lookups::pawn_attacks(from_sq, c)) {
+            if (is_capture) {
+                move_type = is_promotion ? Move::Type::CAPTURE_PROMOTION : Move::Type::CAPTURE;
+            } else if (ep_sq && to_sq == *ep_sq) {
+                move_type = Move::Type::ENPASSANT;
+            } else {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    } else if (promotion_pt) {
         return false;
-    }
-
-    PieceType pt = piece.type();
-    if (move.promotion_piece_type()) {
-        if (pt != constants::PAWN) {
+    } else if (pt == constants::KING && std::abs(to_sq - from_sq) == 2) {
+        // Castling: the king must be on its home square with the path empty and unattacked
+        bool is_kingside = to_sq > from_sq;
+        Square king_home_sq = c == constants::WHITE ? constants::E1 : constants::E8;
+        CastlingRight castling_right =
+            c == constants::WHITE
+                ? (is_kingside ? constants::WHITE_KINGSIDE : constants::WHITE_QUEENSIDE)
+                : (is_kingside ? constants::BLACK_KINGSIDE : constants::BLACK_QUEENSIDE);
+        if (from_sq != king_home_sq || !(castling_rights().value() & castling_right.value()) ||
+            in_check()) {
             return false;
         }
-
-        if (lookups::relative_rank(to_sq.rank(), c) != constants::RANK_8) {
+        Square step_sq = Square{is_kingside ? from_sq + 1 : from_sq - 1};
+        Bitboard path = lookups::intervening(from_sq, is_kingside ? Square{from_sq + 3}
+                                                                  : Square{from_sq - 4});
+        if ((path & occupancy) || attackers_to(step_sq, !c) || attackers_to(to_sq, !c)) {
             return false;
         }
+        move_type = Move::Type::CASTLING;
+    } else if (to_sq_bb & lookups::non_pawn_piece_type_attacks(pt, from_sq, occupancy)) {
+        move_type = is_capture ? Move::Type::CAPTURE : Move::Type::NORMAL;
+    } else {
+        return false;
     }
-
-    bool is_pseudo_legal = false;
-    if (pt == constants::KING) {
-        MoveList castling_move_list;
-        generate_castling(castling_move_list, c);
-        if (castling_move_list.contains(move)) {
-            is_pseudo_legal = true;
-        }
+    if (move.type() != Move::Type::NONE && move.type() != move_type) {
+        return false;
     }
 
-    if (!is_pseudo_legal) {
-        auto ep_sq = enpassant_square();
-        Bitboard to_sq_bb{to_sq};
-        Bitboard opponent_occupancy = color_bb(!c);
-        Bitboard stm_occupancy = color_bb(c);
-        Bitboard occupancy = stm_occupancy | opponent_occupancy;
-        if (pt == constants::PAWN) {
-            if (to_sq == lookups::pawn_shift(from_sq, c) && !(occupancy & to_sq_bb)) {
-                is_pseudo_legal = true;
-            } else if (to_sq == lookups::pawn_shift(from_sq, c, 2) &&
-                       !(occupancy & (to_sq_bb | lookups::pawn_shift(to_sq_bb, !c)))) {
-                is_pseudo_legal = true;
-            } else if (ep_sq && to_sq == *ep_sq &&
-                       (lookups::pawn_attacks(from_sq, c) & Bitboard{*ep_sq})) {
-                is_pseudo_legal = true;
-            } else if (to_sq_bb & lookups::pawn_attacks(from_sq, c) & opponent_occupancy) {
-                is_pseudo_legal = true;
-            }
-        } else if (to_sq_bb & lookups::non_pawn_piece_type_attacks(pt, from_sq, occupancy) &
-                   ~stm_occupancy) {
-            is_pseudo_legal = true;
+    // Evasions: only the king may move out of double check, anything else has to capture the
+    // checker or block its line
+    Bitboard checkers = state().checkers_;
+    if (checkers && pt != constants::KING) {
+        if (checkers.popcount() > 1) {
+            return false;
+        }
+        Bitboard evasion_targets =
+            checkers | lookups::intervening(checkers.forward_bitscan(), king_square(c));
+        bool captures_checker_enpassant =
+            move_type == Move::Type::ENPASSANT && (checkers & lookups::pawn_shift(to_sq_bb, !c));
+        if (!(evasion_targets & to_sq_bb) && !captures_checker_enpassant) {
+            return false;
         }
     }
+    return true;
+}
 
-    if (!is_pseudo_legal) {
+inline bool Position::is_legal_move(Move move) const {
+    if (!is_pseudo_legal(move)) {
         return false;
     }
-    if (!in_check()) {
-        return is_legal_generated_move(move);
+    Move::Type move_type = move_type_of(move);
+    auto promotion_pt = move.promotion_piece_type();
+    if (promotion_pt) {
+        return is_legal_generated_move(
+            Move{move.from_square(), move.to_square(), *promotion_pt, move_type});
     }
-
-    MoveList move_list = legal_move_list();
-    return move_list.contains(move);
+    return is_legal_generated_move(Move{move.from_square(), move.to_square(), move_type});
 }
 
 }  // namespace libchess
@@ -3,34 +3,34 @@
 
 namespace libchess {
 
-inline void Position::generate_quiet_promotions(MoveList& move_list, Color stm) const {
+template <Color::Value::ColorValue c>
+inline void Position::generate_quiet_promotions(MoveList& move_list) const {
+    constexpr Color::Value::ColorValue them = c == Color::Value::WHITE ? Color::Value::BLACK
+                                                                      : Color::Value::WHITE;
     Bitboard promotion_candidates =
-        lookups::pawn_shift(piece_type_bb(constants::PAWN, stm) &
-                                lookups::relative_rank_mask(constants::RANK_7, stm),
-                            stm) &
+        lookups::pawn_shift<c>(piece_type_bb(constants::PAWN, Color{c}) &
+                               lookups::relative_rank_mask<c>(constants::RANK_7)) &
         ~occupancy_bb();
     while (promotion_candidates) {
         Square to_sq = promotion_candidates.forward_bitscan();
         promotion_candidates.forward_popbit();
-        move_list.add(
-            Move{lookups::pawn_shift(to_sq, !stm), to_sq, constants::QUEEN, Move::Type::PROMOTION});
-        move_list.add(Move{
-            lookups::pawn_shift(to_sq, !stm), to_sq, constants::KNIGHT, Move::Type::PROMOTION});
-        move_list.add(
-            Move{lookups::pawn_shift(to_sq, !stm), to_sq, constants::ROOK, Move::Type::PROMOTION});
-        move_list.add(Move{
-            lookups::pawn_shift(to_sq, !stm), to_sq, constants::BISHOP, Move::Type::PROMOTION});
+        Square from_sq = lookups::pawn_shift<them>(to_sq);
+        move_list.add(Move{from_sq, to_sq, constants::QUEEN, Move::Type::PROMOTION});
+        move_list.add(Move{from_sq, to_sq, constants::KNIGHT, Move::Type::PROMOTION});
+        move_list.add(Move{from_sq, to_sq, constants::ROOK, Move::Type::PROMOTION});
+        move_list.add(Move{from_sq, to_sq, constants::BISHOP, Move::Type::PROMOTION});
     }
 }
 
-inline void Position::generate_capture_promotions(MoveList& move_list, Color stm) const {
+template <Color::Value::ColorValue c>
+inline void Position::generate_capture_promotions(MoveList& move_list) const {
     Bitboard pawn_bb = piece_type_bb(constants::PAWN);
-    pawn_bb &= color_bb(stm) & lookups::relative_rank_mask(constants::RANK_7, stm);
-    Bitboard opp_occupancy = color_bb(!stm);
+    pawn_bb &= color_bb(Color{c}) & lookups::relative_rank_mask<c>(constants::RANK_7);
+    Bitboard opp_occupancy = color_bb(!Color{c});
     while (pawn_bb) {
         Square from_sq = pawn_bb.forward_bitscan();
         pawn_bb.forward_popbit();
-        Bitboard attacks_bb = lookups::pawn_attacks(from_sq, stm) & opp_occupancy;
+        Bitboard attacks_bb = lookups::pawn_attacks(from_sq, Color{c}) & opp_occupancy;
         while (attacks_bb) {
             Square to_sq = attacks_bb.forward_bitscan();
             attacks_bb.forward_popbit();
@@ -42,52 +42,57 @@ inline void Position::generate_capture_promotions(MoveList& move_list, Color stm
     }
 }
 
-inline void Position::generate_promotions(MoveList& move_list, Color stm) const {
-    generate_capture_promotions(move_list, stm);
-    generate_quiet_promotions(move_list, stm);
+template <Color::Value::ColorValue c>
+inline void Position::generate_promotions(MoveList& move_list) const {
+    generate_capture_promotions<c>(move_list);
+    generate_quiet_promotions<c>(move_list);
 }
 
-inline void Position::generate_pawn_quiets(MoveList& move_list, Color stm) const {
-    generate_quiet_promotions(move_list, stm);
+template <Color::Value::ColorValue c>
+inline void Position::generate_pawn_quiets(MoveList& move_list) const {
+    constexpr Color::Value::ColorValue them = c == Color::Value::WHITE ? Color::Value::BLACK
+                                                                      : Color::Value::WHITE;
+    generate_quiet_promotions<c>(move_list);
     Bitboard occupancy = occupancy_bb();
     Bitboard single_push_pawn_bb =
-        lookups::pawn_shift(piece_type_bb(constants::PAWN, stm) &
-                                ~lookups::relative_rank_mask(constants::RANK_7, stm),
-                            stm) &
+        lookups::pawn_shift<c>(piece_type_bb(constants::PAWN, Color{c}) &
+                               ~lookups::relative_rank_mask<c>(constants::RANK_7)) &
         ~occupancy;
     Bitboard double_push_pawn_bb =
-        lookups::pawn_shift(
-            single_push_pawn_bb & lookups::relative_rank_mask(constants::RANK_3, stm), stm) &
+        lookups::pawn_shift<c>(single_push_pawn_bb &
+                               lookups::relative_rank_mask<c>(constants::RANK_3)) &
         ~occupancy;
     while (double_push_pawn_bb) {
         Square to_sq = double_push_pawn_bb.forward_bitscan();
         double_push_pawn_bb.forward_popbit();
-        move_list.add(Move{lookups::pawn_shift(to_sq, !stm, 2), to_sq, Move::Type::DOUBLE_PUSH});
+        move_list.add(Move{lookups::pawn_shift<them>(to_sq, 2), to_sq, Move::Type::DOUBLE_PUSH});
     }
     while (single_push_pawn_bb) {
         Square to_sq = single_push_pawn_bb.forward_bitscan();
         single_push_pawn_bb.forward_popbit();
-        move_list.add(Move{lookups::pawn_shift(to_sq, !stm), to_sq, Move::Type::NORMAL});
+        move_list.add(Move{lookups::pawn_shift<them>(to_sq), to_sq, Move::Type::NORMAL});
     }
 }
 
-inline void Position::generate_pawn_captures(MoveList& move_list, Color stm) const {
-    generate_capture_promotions(move_list, stm);
+template <Color::Value::ColorValue c>
+inline void Position::generate_pawn_captures(MoveList& move_list) const {
+    generate_capture_promotions<c>(move_list);
     Bitboard pawn_bb = piece_type_bb(constants::PAWN);
     auto ep_sq = enpassant_square();
     if (ep_sq) {
-        Bitboard ep_candidates = pawn_bb & color_bb(stm) & lookups::pawn_attacks(*ep_sq, !stm);
+        Bitboard ep_candidates =
+            pawn_bb & color_bb(Color{c}) & lookups::pawn_attacks(*ep_sq, !Color{c});
         while (ep_candidates) {
             Square sq = ep_candidates.forward_bitscan();
             ep_candidates.forward_popbit();
             move_list.add(Move{sq, *ep_sq, Move::Type::ENPASSANT});
         }
     }
-    pawn_bb &= color_bb(stm) & ~lookups::relative_rank_mask(constants::RANK_7, stm);
+    pawn_bb &= color_bb(Color{c}) & ~lookups::relative_rank_mask<c>(constants::RANK_7);
     while (pawn_bb) {
         Square from_sq = pawn_bb.forward_bitscan();
         pawn_bb.forward_popbit();
-        Bitboard attacks_bb = lookups::pawn_attacks(from_sq, stm) & color_bb(!stm);
+        Bitboard attacks_bb = lookups::pawn_attacks(from_sq, Color{c}) & color_bb(!Color{c});
         while (attacks_bb) {
             Square to_sq = attacks_bb.forward_bitscan();
             attacks_bb.forward_popbit();
@@ -96,9 +101,10 @@ inline void Position::generate_pawn_captures(MoveList& move_list, Color stm) con
     }
 }
 
-inline void Position::generate_pawn_moves(MoveList& move_list, Color stm) const {
-    generate_pawn_captures(move_list, stm);
-    generate_pawn_quiets(move_list, stm);
+template <Color::Value::ColorValue c>
+inline void Position::generate_pawn_moves(MoveList& move_list) const {
+    generate_pawn_captures<c>(move_list);
+    generate_pawn_quiets<c>(move_list);
 }
 
 inline void Position::generate_non_pawn_quiets(PieceType pt, MoveList& move_list, Color stm) const {
@@ -159,7 +165,9 @@ inline void Position::generate_king_moves(MoveList& move_list, Color stm) const
     generate_non_pawn_captures(constants::KING, move_list, stm);
 }
 
-inline void Position::generate_castling(MoveList& move_list, Color c) const {
+// Whether the side can castle kingside (side 0) or queenside (side 1) right now
+template <Color::Value::ColorValue c>
+inline bool Position::can_castle(int side) const {
     const int castling_possibilities[2][2] = {
         {constants::WHITE_KINGSIDE.value(), constants::WHITE_QUEENSIDE.value()},
         {constants::BLACK_KINGSIDE.value(), constants::BLACK_QUEENSIDE.value()},
@@ -167,62 +175,67 @@ inline void Position::generate_castling(MoveList& move_list, Color c) const {
     const Square castling_intermediate_sqs[2][2][2] = {
         {{constants::F1, constants::G1}, {constants::D1, constants::C1}},
         {{constants::F8, constants::G8}, {constants::D8, constants::C8}}};
-    const Square castling_king_sqs[2][2][2] = {
-        {{constants::E1, constants::G1}, {constants::E1, constants::C1}},
-        {{constants::E8, constants::G8}, {constants::E8, constants::C8}}};
+    const Square castling_king_sqs[2] = {constants::E1, constants::E8};
     const Bitboard castle_mask[2][2] = {
         {(Bitboard{constants::F1} | Bitboard{constants::G1}),
          (Bitboard{constants::D1} | Bitboard{constants::C1} | Bitboard{constants::B1})},
         {(Bitboard{constants::F8} | Bitboard{constants::G8}),
          (Bitboard{constants::D8} | Bitboard{constants::C8} | Bitboard{constants::B8})}};
 
-    Bitboard occupancy = occupancy_bb();
-    if ((castling_possibilities[c][0] & castling_rights().value()) &&
-        !(castle_mask[c][0] & occupancy) && !(attackers_to(castling_king_sqs[c][0][0], !c)) &&
-        !(attackers_to(castling_intermediate_sqs[c][0][0], !c)) &&
-        !(attackers_to(castling_intermediate_sqs[c][0][1], !c))) {
-        move_list.add(
-            Move{castling_king_sqs[c][0][0], castling_king_sqs[c][0][1], Move::Type::CASTLING});
-    }
-    if ((castling_possibilities[c][1] & castling_rights().value()) &&
-        !(castle_mask[c][1] & occupancy) && !(attackers_to(castling_king_sqs[c][0][0], !c)) &&
-        !(attackers_to(castling_intermediate_sqs[c][1][0], !c)) &&
-        !(attackers_to(castling_intermediate_sqs[c][1][1], !c))) {
-        move_list.add(
-            Move{castling_king_sqs[c][1][0], castling_king_sqs[c][1][1], Move::Type::CASTLING});
+    Color them = !Color{c};
+    return (castling_possibilities[c][side] & castling_rights().value()) &&
+           !(castle_mask[c][side] & occupancy_bb()) &&
+           !(attackers_to(castling_king_sqs[c], them)) &&
+           !(attackers_to(castling_intermediate_sqs[c][side][0], them)) &&
+           !(attackers_to(castling_intermediate_sqs[c][side][1], them));
+}
+
+template <Color::Value::ColorValue c>
+inline void Position::generate_castling(MoveList& move_list) const {
+    const Square castling_king_sqs[2][2][2] = {
+        {{constants::E1, constants::G1}, {constants::E1, constants::C1}},
+        {{constants::E8, constants::G8}, {constants::E8, constants::C8}}};
+
+    for (int side = 0; side < 2; ++side) {
+        if (can_castle<c>(side)) {
+            move_list.add(Move{castling_king_sqs[c][side][0], castling_king_sqs[c][side][1],
+                               Move::Type::CASTLING});
+        }
     }
 }
 
-inline void Position::generate_checker_block_moves(MoveList& move_list, Color c) const {
-    Bitboard checkers = checkers_to(c);
+template <Color::Value::ColorValue c>
+inline void Position::generate_checker_block_moves(MoveList& move_list) const {
+    constexpr Color::Value::ColorValue them = c == Color::Value::WHITE ? Color::Value::BLACK
+                                                                      : Color::Value::WHITE;
+    Bitboard checkers = checkers_to(Color{c});
     if (checkers.popcount() > 1) {
         return;
     }
 
-    Square king_sq = king_square(c);
+    Square king_sq = king_square(Color{c});
     Square checker_pos = checkers.forward_bitscan();
     Bitboard checker_intercept_bb = lookups::intervening(king_sq, checker_pos);
     if (!checker_intercept_bb) {
         return;
     }
 
-    Bitboard pawns = piece_type_bb(constants::PAWN, c);
-    Bitboard shifted_intercepts = lookups::pawn_shift(checker_intercept_bb, !c);
+    Bitboard pawns = piece_type_bb(constants::PAWN, Color{c});
+    Bitboard shifted_intercepts = lookups::pawn_shift<them>(checker_intercept_bb);
     Bitboard single_push_pawn_blocks = shifted_intercepts & pawns;
     Bitboard double_push_pawn_blocks =
-        lookups::pawn_shift(shifted_intercepts & ~occupancy_bb(), !c) & pawns &
-        lookups::relative_rank_mask(constants::RANK_2, c);
+        lookups::pawn_shift<them>(shifted_intercepts & ~occupancy_bb()) & pawns &
+        lookups::relative_rank_mask<c>(constants::RANK_2);
     while (double_push_pawn_blocks) {
         Square pawn_sq = double_push_pawn_blocks.forward_bitscan();
         double_push_pawn_blocks.forward_popbit();
-        move_list.add(Move{pawn_sq, lookups::pawn_shift(pawn_sq, c, 2), Move::Type::DOUBLE_PUSH});
+        move_list.add(Move{pawn_sq, lookups::pawn_shift<c>(pawn_sq, 2), Move::Type::DOUBLE_PUSH});
     }
     while (single_push_pawn_blocks) {
         Square pawn_sq = single_push_pawn_blocks.forward_bitscan();
         single_push_pawn_blocks.forward_popbit();
-        Square target_sq = lookups::pawn_shift(pawn_sq, c);
-        if ((c == constants::WHITE && pawn_sq.rank() == constants::RANK_7) ||
-            (c == constants::BLACK && pawn_sq.rank() == constants::RANK_2)) {
+        Square target_sq = lookups::pawn_shift<c>(pawn_sq);
+        if (Bitboard{pawn_sq} & lookups::relative_rank_mask<c>(constants::RANK_7)) {
             move_list.add(Move{pawn_sq, target_sq, constants::QUEEN, Move::Type::PROMOTION});
             move_list.add(Move{pawn_sq, target_sq, constants::KNIGHT, Move::Type::PROMOTION});
             move_list.add(Move{pawn_sq, target_sq, constants::BISHOP, Move::Type::PROMOTION});
@@ -236,7 +249,7 @@ inline void Position::generate_checker_block_moves(MoveList& move_list, Color c)
     while (checker_intercept_bb) {
         Square sq = checker_intercept_bb.forward_bitscan();
         checker_intercept_bb.forward_popbit();
-        Bitboard blockers = attackers_to(sq, c) & excluded_pieces_mask;
+        Bitboard blockers = attackers_to(sq, Color{c}) & excluded_pieces_mask;
         while (blockers) {
             Square atker_sq = blockers.forward_bitscan();
             blockers.forward_popbit();
@@ -245,16 +258,19 @@ inline void Position::generate_checker_block_moves(MoveList& move_list, Color c)
     }
 }
 
-inline void Position::generate_checker_capture_moves(MoveList& move_list, Color c) const {
-    Bitboard checkers = checkers_to(c);
+template <Color::Value::ColorValue c>
+inline void Position::generate_checker_capture_moves(MoveList& move_list) const {
+    constexpr Color::Value::ColorValue them = c == Color::Value::WHITE ? Color::Value::BLACK
+                                                                      : Color::Value::WHITE;
+    Bitboard checkers = checkers_to(Color{c});
     if (checkers.popcount() > 1) {
         return;
     }
 
-    Bitboard pawns = piece_type_bb(constants::PAWN, c);
+    Bitboard pawns = piece_type_bb(constants::PAWN, Color{c});
     auto ep_square = enpassant_square();
-    if (ep_square && (lookups::pawn_shift(Bitboard{*ep_square}, !c) & checkers)) {
-        Bitboard ep_candidates = pawns & lookups::pawn_attacks(*ep_square, !c);
+    if (ep_square && (lookups::pawn_shift<them>(Bitboard{*ep_square}) & checkers)) {
+        Bitboard ep_candidates = pawns & lookups::pawn_attacks(*ep_square, Color{them});
         while (ep_candidates) {
             Square sq = ep_candidates.forward_bitscan();
             ep_candidates.forward_popbit();
@@ -263,8 +279,8 @@ inline void Position::generate_checker_capture_moves(MoveList& move_list, Color
     }
 
     Square checker_sq = checkers.forward_bitscan();
-    Bitboard attackers = attackers_to(checker_sq, c) & ~Bitboard{king_square(c)};
-    Bitboard rank7_pawns = pawns & lookups::relative_rank_mask(constants::RANK_7, c);
+    Bitboard attackers = attackers_to(checker_sq, Color{c}) & ~Bitboard{king_square(Color{c})};
+    Bitboard rank7_pawns = pawns & lookups::relative_rank_mask<c>(constants::RANK_7);
     Bitboard pawn_prom_attackers = attackers & rank7_pawns;
     while (pawn_prom_attackers) {
         Square sq = pawn_prom_attackers.forward_bitscan();
@@ -282,18 +298,18 @@ inline void Position::generate_checker_capture_moves(MoveList& move_list, Color
     }
 }
 
-inline MoveList Position::check_evasion_move_list(Color c) const {
-    MoveList move_list;
-    Square king_sq = king_square(c);
-    Bitboard checkers = checkers_to(c);
+template <Color::Value::ColorValue c>
+inline void Position::generate_check_evasions(MoveList& move_list) const {
+    Square king_sq = king_square(Color{c});
+    Bitboard checkers = checkers_to(Color{c});
     Bitboard non_king_occupancy = occupancy_bb() ^ Bitboard { king_sq };
 
-    Bitboard evasions = lookups::king_attacks(king_sq) & ~color_bb(c);
-    Bitboard opp_occupancy = color_bb(!c);
+    Bitboard evasions = lookups::king_attacks(king_sq) & ~color_bb(Color{c});
+    Bitboard opp_occupancy = color_bb(!Color{c});
     while (evasions) {
         Square sq = evasions.forward_bitscan();
         evasions.forward_popbit();
-        if (!(attackers_to(sq, non_king_occupancy, !c))) {
+        if (!(attackers_to(sq, non_king_occupancy, !Color{c}))) {
             if (Bitboard{sq} & opp_occupancy) {
                 move_list.add(Move{king_sq, sq, Move::Type::CAPTURE});
             } else {
@@ -303,41 +319,411 @@ inline MoveList Position::check_evasion_move_list(Color c) const {
     }
 
     if (checkers.popcount() > 1) {
-        return move_list;
+        return;
     }
 
-    generate_checker_capture_moves(move_list, c);
-    generate_checker_block_moves(move_list, c);
-    return move_list;
+    generate_checker_capture_moves<c>(move_list);
+    generate_checker_block_moves<c>(move_list);
 }
 
-inline MoveList Position::check_evasion_move_list() const {
-    return check_evasion_move_list(side_to_move());
+template <Color::Value::ColorValue c>
+inline void Position::generate_quiet_moves(MoveList& move_list) const {
+    generate_pawn_quiets<c>(move_list);
+    generate_non_pawn_quiets(constants::KNIGHT, move_list, Color{c});
+    generate_non_pawn_quiets(constants::BISHOP, move_list, Color{c});
+    generate_non_pawn_quiets(constants::ROOK, move_list, Color{c});
+    generate_non_pawn_quiets(constants::QUEEN, move_list, Color{c});
+    generate_non_pawn_quiets(constants::KING, move_list, Color{c});
+    generate_castling<c>(move_list);
+}
+
+template <Color::Value::ColorValue c>
+inline void Position::generate_capture_moves(MoveList& move_list) const {
+    generate_pawn_captures<c>(move_list);
+    generate_non_pawn_captures(constants::KNIGHT, move_list, Color{c});
+    generate_non_pawn_captures(constants::BISHOP, move_list, Color{c});
+    generate_non_pawn_captures(constants::ROOK, move_list, Color{c});
+    generate_non_pawn_captures(constants::QUEEN, move_list, Color{c});
+    generate_non_pawn_captures(constants::KING, move_list, Color{c});
+}
+
+template <Color::Value::ColorValue c>
+inline void Position::generate_legal_moves(MoveList& move_list) const {
+    constexpr Color::Value::ColorValue them = c == Color::Value::WHITE ? Color::Value::BLACK
+                                                                      : Color::Value::WHITE;
+    Square king_sq = king_square(Color{c});
+    Bitboard occupancy = occupancy_bb();
+    Bitboard opp_occupancy = color_bb(Color{them});
+    Bitboard checkers = checkers_to(Color{c});
+
+    // The king is lifted off the board so that sliders checking it also cover its retreat squares
+    Bitboard non_king_occupancy = occupancy ^ Bitboard{king_sq};
+    Bitboard king_targets = lookups::king_attacks(king_sq) & ~color_bb(Color{c});
+    while (king_targets) {
+        Square to_sq = king_targets.forward_bitscan();
+        king_targets.forward_popbit();
+        if (attackers_to(to_sq, non_king_occupancy, Color{them})) {
+            continue;
+        }
+        if (Bitboard{to_sq} & opp_occupancy) {
+            move_list.add(Move{king_sq, to_sq, Move::Type::CAPTURE});
+        } else {
+            move_list.add(Move{king_sq, to_sq, Move::Type::NORMAL});
+        }
+    }
+
+    if (checkers.popcount() > 1) {
+        return;
+    }
+
+    // Non-king moves must land on the check mask, and pinned pieces must stay on their pin ray
+    Bitboard check_mask = ~Bitboard{};
+    if (checkers) {
+        check_mask = checkers | lookups::intervening(king_sq, checkers.forward_bitscan());
+    } else {
+        generate_castling<c>(move_list);
+    }
+    Bitboard pinned = pinned_pieces_of(Color{c});
+    Bitboard quiet_targets = ~occupancy & check_mask;
+    Bitboard capture_targets = opp_occupancy & check_mask;
+
+    for (PieceType pt = constants::KNIGHT; pt <= constants::QUEEN; ++pt) {
+        Bitboard piece_bb = piece_type_bb(pt, Color{c});
+        while (piece_bb) {
+            Square from_sq = piece_bb.forward_bitscan();
+            piece_bb.forward_popbit();
+            Bitboard atks = lookups::non_pawn_piece_type_attacks(pt, from_sq, occupancy);
+            if (pinned & Bitboard{from_sq}) {
+                atks &= lookups::full_ray(king_sq, from_sq);
+            }
+            Bitboard captures = atks & capture_targets;
+            while (captures) {
+                Square to_sq = captures.forward_bitscan();
+                captures.forward_popbit();
+                move_list.add(Move{from_sq, to_sq, Move::Type::CAPTURE});
+            }
+            Bitboard quiets = atks & quiet_targets;
+            while (quiets) {
+                Square to_sq = quiets.forward_bitscan();
+                quiets.forward_popbit();
+                move_list.add(Move{from_sq, to_sq, Move::Type::NORMAL});
+            }
+        }
+    }
+
+    auto is_pinned_off_ray = [&](Square from_sq, Square to_sq) {
+        return (pinned & Bitboard{from_sq}) &&
+               !(lookups::full_ray(king_sq, from_sq) & Bitboard{to_sq});
+    };
+    auto add_promotions = [&](Square from_sq, Square to_sq, Move::Type type) {
+        move_list.add(Move{from_sq, to_sq, constants::QUEEN, type});
+        move_list.add(Move{from_sq, to_sq, constants::KNIGHT, type});
+        move_list.add(Move{from_sq, to_sq, constants::ROOK, type});
+        move_list.add(Move{from_sq, to_sq, constants::BISHOP, type});
+    };
+
+    Bitboard pawn_bb = piece_type_bb(constants::PAWN, Color{c});
+    constexpr Bitboard promotion_rank = lookups::relative_rank_mask<c>(constants::RANK_8);
+    Bitboard single_push_pawn_bb = lookups::pawn_shift<c>(pawn_bb) & ~occupancy;
+    Bitboard double_push_pawn_bb =
+        lookups::pawn_shift<c>(single_push_pawn_bb &
+                               lookups::relative_rank_mask<c>(constants::RANK_3)) &
+        quiet_targets;
+    single_push_pawn_bb &= check_mask;
+    while (single_push_pawn_bb) {
+        Square to_sq = single_push_pawn_bb.forward_bitscan();
+        single_push_pawn_bb.forward_popbit();
+        Square from_sq = lookups::pawn_shift<them>(to_sq);
+        if (is_pinned_off_ray(from_sq, to_sq)) {
+            continue;
+        }
+        if (Bitboard{to_sq} & promotion_rank) {
+            add_promotions(from_sq, to_sq, Move::Type::PROMOTION);
+        } else {
+            move_list.add(Move{from_sq, to_sq, Move::Type::NORMAL});
+        }
+    }
+    while (double_push_pawn_bb) {
+        Square to_sq = double_push_pawn_bb.forward_bitscan();
+        double_push_pawn_bb.forward_popbit();
+        Square from_sq = lookups::pawn_shift<them>(to_sq, 2);
+        if (!is_pinned_off_ray(from_sq, to_sq)) {
+            move_list.add(Move{from_sq, to_sq, Move::Type::DOUBLE_PUSH});
+        }
+    }
+
+    Bitboard capturing_pawn_bb = pawn_bb;
+    while (capturing_pawn_bb) {
+        Square from_sq = capturing_pawn_bb.forward_bitscan();
+        capturing_pawn_bb.forward_popbit();
+        Bitboard atks = lookups::pawn_attacks(from_sq, Color{c}) & capture_targets;
+        if (pinned & Bitboard{from_sq}) {
+            atks &= lookups::full_ray(king_sq, from_sq);
+        }
+        while (atks) {
+            Square to_sq = atks.forward_bitscan();
+            atks.forward_popbit();
+            if (Bitboard{to_sq} & promotion_rank) {
+                add_promotions(from_sq, to_sq, Move::Type::CAPTURE_PROMOTION);
+            } else {
+                move_list.add(Move{from_sq, to_sq, Move::Type::CAPTURE});
+            }
+        }
+    }
+
+    // Enpassant removes two pieces from a line at once, so each candidate is verified directly
+    auto ep_sq = enpassant_square();
+    if (ep_sq) {
+        Bitboard ep_bb = Bitboard{*ep_sq};
+        Bitboard captured_bb = lookups::pawn_shift<them>(ep_bb);
+        Bitboard ep_candidates = pawn_bb & lookups::pawn_attacks(*ep_sq, Color{them});
+        while (ep_candidates) {
+            Square from_sq = ep_candidates.forward_bitscan();
+            ep_candidates.forward_popbit();
+            Bitboard post_ep_occupancy = (occupancy ^ Bitboard{from_sq} ^ captured_bb) | ep_bb;
+            if (!(attackers_to(king_sq, post_ep_occupancy) & opp_occupancy & ~captured_bb)) {
+                move_list.add(Move{from_sq, *ep_sq, Move::Type::ENPASSANT});
+            }
+        }
+    }
+}
+
+// Mirrors generate_legal_moves, but only counts: targets are popcounted per piece and unpinned
+// pawn pushes are counted a whole set at a time
+template <Color::Value::ColorValue c>
+inline int Position::count_legal_moves() const {
+    constexpr Color::Value::ColorValue them = c == Color::Value::WHITE ? Color::Value::BLACK
+                                                                      : Color::Value::WHITE;
+    Square king_sq = king_square(Color{c});
+    Bitboard occupancy = occupancy_bb();
+    Bitboard opp_occupancy = color_bb(Color{them});
+    Bitboard checkers = checkers_to(Color{c});
+    int count = 0;
+
+    Bitboard non_king_occupancy = occupancy ^ Bitboard{king_sq};
+    Bitboard king_targets = lookups::king_attacks(king_sq) & ~color_bb(Color{c});
+    while (king_targets) {
+        Square to_sq = king_targets.forward_bitscan();
+        king_targets.forward_popbit();
+        if (!attackers_to(to_sq, non_king_occupancy, Color{them})) {
+            ++count;
+        }
+    }
+
+    if (checkers.popcount() > 1) {
+        return count;
+    }
+
+    Bitboard check_mask = ~Bitboard{};
+    if (checkers) {
+        check_mask = checkers | lookups::intervening(king_sq, checkers.forward_bitscan());
+    } else {
+        count += can_castle<c>(0) + can_castle<c>(1);
+    }
+    Bitboard pinned = pinned_pieces_of(Color{c});
+    Bitboard targets = ~color_bb(Color{c}) & check_mask;
+    Bitboard quiet_targets = ~occupancy & check_mask;
+    Bitboard capture_targets = opp_occupancy & check_mask;
+
+    for (PieceType pt = constants::KNIGHT; pt <= constants::QUEEN; ++pt) {
+        Bitboard piece_bb = piece_type_bb(pt, Color{c});
+        while (piece_bb) {
+            Square from_sq = piece_bb.forward_bitscan();
+            piece_bb.forward_popbit();
+            Bitboard atks = lookups::non_pawn_piece_type_attacks(pt, from_sq, occupancy) & targets;
+            if (pinned & Bitboard{from_sq}) {
+                atks &= lookups::full_ray(king_sq, from_sq);
+            }
+            count += atks.popcount();
+        }
+    }
+
+    // Every promotion counts four times, once per promotion piece type
+    constexpr Bitboard promotion_rank = lookups::relative_rank_mask<c>(constants::RANK_8);
+    auto count_pawn_targets = [&](Bitboard pawn_targets) {
+        return pawn_targets.popcount() + 3 * (pawn_targets & promotion_rank).popcount();
+    };
+
+    Bitboard pawn_bb = piece_type_bb(constants::PAWN, Color{c});
+    Bitboard free_pawn_bb = pawn_bb & ~pinned;
+    Bitboard single_push_pawn_bb = lookups::pawn_shift<c>(free_pawn_bb) & ~occupancy;
+    Bitboard double_push_pawn_bb =
+        lookups::pawn_shift<c>(single_push_pawn_bb &
+                               lookups::relative_rank_mask<c>(constants::RANK_3)) &
+        quiet_targets;
+    count += count_pawn_targets(single_push_pawn_bb & check_mask);
+    count += double_push_pawn_bb.popcount();
+    while (free_pawn_bb) {
+        Square from_sq = free_pawn_bb.forward_bitscan();
+        free_pawn_bb.forward_popbit();
+        count += count_pawn_targets(lookups::pawn_attacks(from_sq, Color{c}) & capture_targets);
+    }
+
+    Bitboard pinned_pawn_bb = pawn_bb & pinned;
+    while (pinned_pawn_bb) {
+        Square from_sq = pinned_pawn_bb.forward_bitscan();
+        pinned_pawn_bb.forward_popbit();
+        Bitboard single_push_bb = lookups::pawn_shift<c>(Bitboard{from_sq}) & ~occupancy;
+        Bitboard double_push_bb =
+            lookups::pawn_shift<c>(single_push_bb &
+                                   lookups::relative_rank_mask<c>(constants::RANK_3)) &
+            ~occupancy;
+        Bitboard pawn_targets = ((single_push_bb | double_push_bb) & check_mask) |
+                                (lookups::pawn_attacks(from_sq, Color{c}) & capture_targets);
+        count += count_pawn_targets(pawn_targets & lookups::full_ray(king_sq, from_sq));
+    }
+
+    auto ep_sq = enpassant_square();
+    if (ep_sq) {
+        Bitboard ep_bb = Bitboard{*ep_sq};
+        Bitboard captured_bb = lookups::pawn_shift<them>(ep_bb);
+        Bitboard ep_candidates = pawn_bb & lookups::pawn_attacks(*ep_sq, Color{them});
+        while (ep_candidates) {
+            Square from_sq = ep_candidates.forward_bitscan();
+            ep_candidates.forward_popbit();
+            Bitboard post_ep_occupancy = (occupancy ^ Bitboard{from_sq} ^ captured_bb) | ep_bb;
+            if (!(attackers_to(king_sq, post_ep_occupancy) & opp_occupancy & ~captured_bb)) {
+                ++count;
+            }
+        }
+    }
+    return count;
+}
+
+template <Color::Value::ColorValue c, Position::GenType gen_type>
+inline void Position::generate(MoveList& move_list) const {
+    if constexpr (gen_type == GenType::CAPTURES) {
+        generate_capture_moves<c>(move_list);
+    } else if constexpr (gen_type == GenType::QUIETS) {
+        generate_quiet_moves<c>(move_list);
+    } else if constexpr (gen_type == GenType::EVASIONS) {
+        generate_check_evasions<c>(move_list);
+    } else if constexpr (gen_type == GenType::ALL) {
+        generate_capture_moves<c>(move_list);
+        generate_quiet_moves<c>(move_list);
+    } else {
+        generate_legal_moves<c>(move_list);
+    }
+}
+
+// Runtime-color dispatchers
+inline void Position::generate_quiet_promotions(MoveList& move_list, Color stm) const {
+    if (stm == constants::WHITE) {
+        generate_quiet_promotions<Color::Value::WHITE>(move_list);
+    } else {
+        generate_quiet_promotions<Color::Value::BLACK>(move_list);
+    }
+}
+
+inline void Position::generate_capture_promotions(MoveList& move_list, Color stm) const {
+    if (stm == constants::WHITE) {
+        generate_capture_promotions<Color::Value::WHITE>(move_list);
+    } else {
+        generate_capture_promotions<Color::Value::BLACK>(move_list);
+    }
+}
+
+inline void Position::generate_promotions(MoveList& move_list, Color stm) const {
+    if (stm == constants::WHITE) {
+        generate_promotions<Color::Value::WHITE>(move_list);
+    } else {
+        generate_promotions<Color::Value::BLACK>(move_list);
+    }
+}
+
+inline void Position::generate_pawn_quiets(MoveList& move_list, Color stm) const {
+    if (stm == constants::WHITE) {
+        generate_pawn_quiets<Color::Value::WHITE>(move_list);
+    } else {
+        generate_pawn_quiets<Color::Value::BLACK>(move_list);
+    }
+}
+
+inline void Position::generate_pawn_captures(MoveList& move_list, Color stm) const {
+    if (stm == constants::WHITE) {
+        generate_pawn_captures<Color::Value::WHITE>(move_list);
+    } else {
+        generate_pawn_captures<Color::Value::BLACK>(move_list);
+    }
+}
+
+inline void Position::generate_pawn_moves(MoveList& move_list, Color stm) const {
+    if (stm == constants::WHITE) {
+        generate_pawn_moves<Color::Value::WHITE>(move_list);
+    } else {
+        generate_pawn_moves<Color::Value::BLACK>(move_list);
+    }
+}
+
+inline void Position::generate_castling(MoveList& move_list, Color stm) const {
+    if (stm == constants::WHITE) {
+        generate_castling<Color::Value::WHITE>(move_list);
+    } else {
+        generate_castling<Color::Value::BLACK>(move_list);
+    }
+}
+
+inline void Position::generate_checker_block_moves(MoveList& move_list, Color stm) const {
+    if (stm == constants::WHITE) {
+        generate_checker_block_moves<Color::Value::WHITE>(move_list);
+    } else {
+        generate_checker_block_moves<Color::Value::BLACK>(move_list);
+    }
+}
+
+inline void Position::generate_checker_capture_moves(MoveList& move_list, Color stm) const {
+    if (stm == constants::WHITE) {
+        generate_checker_capture_moves<Color::Value::WHITE>(move_list);
+    } else {
+        generate_checker_capture_moves<Color::Value::BLACK>(move_list);
+    }
 }
 
 inline void Position::generate_quiet_moves(MoveList& move_list, Color stm) const {
-    generate_pawn_quiets(move_list, stm);
-    generate_non_pawn_quiets(constants::KNIGHT, move_list, stm);
-    generate_non_pawn_quiets(constants::BISHOP, move_list, stm);
-    generate_non_pawn_quiets(constants::ROOK, move_list, stm);
-    generate_non_pawn_quiets(constants::QUEEN, move_list, stm);
-    generate_non_pawn_quiets(constants::KING, move_list, stm);
-    generate_castling(move_list, stm);
+    if (stm == constants::WHITE) {
+        generate_quiet_moves<Color::Value::WHITE>(move_list);
+    } else {
+        generate_quiet_moves<Color::Value::BLACK>(move_list);
+    }
 }
 
 inline void Position::generate_capture_moves(MoveList& move_list, Color stm) const {
-    generate_pawn_captures(move_list, stm);
-    generate_non_pawn_captures(constants::KNIGHT, move_list, stm);
-    generate_non_pawn_captures(constants::BISHOP, move_list, stm);
-    generate_non_pawn_captures(constants::ROOK, move_list, stm);
-    generate_non_pawn_captures(constants::QUEEN, move_list, stm);
-    generate_non_pawn_captures(constants::KING, move_list, stm);
+    if (stm == constants::WHITE) {
+        generate_capture_moves<Color::Value::WHITE>(move_list);
+    } else {
+        generate_capture_moves<Color::Value::BLACK>(move_list);
+    }
+}
+
+inline void Position::generate_legal_moves(MoveList& move_list, Color stm) const {
+    if (stm == constants::WHITE) {
+        generate_legal_moves<Color::Value::WHITE>(move_list);
+    } else {
+        generate_legal_moves<Color::Value::BLACK>(move_list);
+    }
+}
+
+inline MoveList Position::check_evasion_move_list(Color stm) const {
+    MoveList move_list;
+    if (stm == constants::WHITE) {
+        generate<Color::Value::WHITE, GenType::EVASIONS>(move_list);
+    } else {
+        generate<Color::Value::BLACK, GenType::EVASIONS>(move_list);
+    }
+    return move_list;
+}
+
+inline MoveList Position::check_evasion_move_list() const {
+    return check_evasion_move_list(side_to_move());
 }
 
 inline MoveList Position::pseudo_legal_move_list(Color stm) const {
     MoveList move_list;
-    generate_capture_moves(move_list, stm);
-    generate_quiet_moves(move_list, stm);
+    if (stm == constants::WHITE) {
+        generate<Color::Value::WHITE, GenType::ALL>(move_list);
+    } else {
+        generate<Color::Value::BLACK, GenType::ALL>(move_list);
+    }
     return move_list;
 }
 
@@ -349,17 +735,11 @@ inline MoveList Position::pseudo_legal_move_list() const {
 }
 
 inline MoveList Position::legal_move_list(Color stm) const {
-    MoveList move_list = checkers_to(stm) ? check_evasion_move_list() : pseudo_legal_move_list();
-    Bitboard pinned = pinned_pieces_of(stm);
-    for (auto move = move_list.begin(); move != move_list.end();) {
-        if (((pinned & Bitboard{move->from_square()}) || move->from_square() == king_square(stm) ||
-             move->type() == Move::Type::ENPASSANT) &&
-            !is_legal_generated_move(*move)) {
-            *move = *(move_list.end() - 1);
-            move_list.pop_back();
-        } else {
-            ++move;
-        }
+    MoveList move_list;
+    if (stm == constants::WHITE) {
+        generate<Color::Value::WHITE, GenType::LEGAL>(move_list);
+    } else {
+        generate<Color::Value::BLACK, GenType::LEGAL>(move_list);
     }
     return move_list;
 }
@@ -371,6 +751,21 @@ inline MoveList Position::legal_move_list() const {
     return legal_move_list(side_to_move());
 }
 
+inline int Position::legal_move_count(Color stm) const {
+    if (stm == constants::WHITE) {
+        return count_legal_moves<Color::Value::WHITE>();
+    } else {
+        return count_legal_moves<Color::Value::BLACK>();
+    }
+}
+
+inline int Position::legal_move_count() const {
+    if (halfmoves() >= 150 || is_repeat(4)) {
+        return 0;
+    }
+    return legal_move_count(side_to_move());
+}
+
 }  // namespace libchess
 
 #endif  // LIBCHESS_MOVEGENERATION_H
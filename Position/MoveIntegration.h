@@ -58,30 +58,39 @@ inline bool Position::is_promotion_move(Move move) const {
 }
 
 inline void Position::unmake_move() {
-    auto move = state().previous_move_;
+    if (!state().previous_move()) {
+        if (side_to_move() == constants::WHITE) {
+            --fullmoves_;
+        }
+        --ply_;
+        reverse_side_to_move();
+        return;
+    }
+    unmake_generated_move();
+}
+
+inline void Position::unmake_generated_move() {
+    const State& curr_state = state();
+    Move move = curr_state.previous_move_;
     if (side_to_move() == constants::WHITE) {
         --fullmoves_;
     }
-    Move::Type move_type = state().move_type_;
-    auto captured_pt = state().captured_pt_;
+    Move::Type move_type = curr_state.move_type_;
+    auto captured_pt = curr_state.captured_pt();
+    PieceType moving_pt = PieceType{curr_state.moved_pt_};
     --ply_;
-    history_.pop_back();
     reverse_side_to_move();
-    if (!move) {
-        return;
-    }
     Color stm = side_to_move();
 
-    Square from_square = move->from_square();
-    Square to_square = move->to_square();
+    Square from_square = move.from_square();
+    Square to_square = move.to_square();
 
-    auto moving_pt = piece_type_on(to_square);
     switch (move_type) {
         case Move::Type::NORMAL:
-            move_piece(to_square, from_square, *moving_pt, stm);
+            move_piece(to_square, from_square, moving_pt, stm);
             break;
         case Move::Type::CAPTURE:
-            move_piece(to_square, from_square, *moving_pt, stm);
+            move_piece(to_square, from_square, moving_pt, stm);
             put_piece(to_square, *captured_pt, !stm);
             break;
         case Move::Type::DOUBLE_PUSH:
@@ -113,11 +122,11 @@ inline void Position::unmake_move() {
             }
             break;
         case Move::Type::PROMOTION:
-            remove_piece(to_square, *move->promotion_piece_type(), stm);
+            remove_piece(to_square, *move.promotion_piece_type(), stm);
             put_piece(from_square, constants::PAWN, stm);
             break;
         case Move::Type::CAPTURE_PROMOTION:
-            remove_piece(to_square, *move->promotion_piece_type(), stm);
+            remove_piece(to_square, *move.promotion_piece_type(), stm);
             put_piece(from_square, constants::PAWN, stm);
             put_piece(to_square, *captured_pt, !stm);
             break;
@@ -127,105 +136,126 @@ inline void Position::unmake_move() {
 }
 
 inline void Position::make_move(Move move) {
+    make_typed_move(move, move_type_of(move));
+}
+
+inline void Position::make_generated_move(Move move) {
+    assert(move.type() != Move::Type::NONE);
+    make_typed_move(move, move.type());
+}
+
+inline void Position::make_typed_move(Move move, Move::Type move_type) {
     Color stm = side_to_move();
     if (stm == constants::BLACK) {
         ++fullmoves_;
     }
-    ++ply_;
-    history_.push_back(State{});
+    push_state();
     State& prev_state = state_mut_ref(ply_ - 1);
     State& next_state = state_mut_ref();
     next_state.halfmoves_ = prev_state.halfmoves_ + 1;
+    next_state.plies_from_null_ = prev_state.plies_from_null_ + 1;
     next_state.previous_move_ = move;
-    next_state.enpassant_square_ = {};
 
     Square from_square = move.from_square();
     Square to_square = move.to_square();
 
-    next_state.castling_rights_ = CastlingRights{prev_state.castling_rights_.value() &
-                                                 castling_spoilers[from_square.value()] &
-                                                 castling_spoilers[to_square.value()]};
+    next_state.castling_rights_ = prev_state.castling_rights_ &
+                                  castling_spoilers[from_square.value()] &
+                                  castling_spoilers[to_square.value()];
 
     auto moving_pt = piece_type_on(from_square);
-    auto captured_pt = piece_type_on(to_square);
+    std::optional<PieceType> captured_pt;
+    if (move_type == Move::Type::CAPTURE || move_type == Move::Type::CAPTURE_PROMOTION) {
+        captured_pt = piece_type_on(to_square);
+    }
     auto promotion_pt = move.promotion_piece_type();
 
-    Move::Type move_type = move_type_of(move);
-
     if (moving_pt == constants::PAWN || captured_pt) {
         next_state.halfmoves_ = 0;
     }
 
-    bool calc_hash = true;
-
     next_state.hash_ = prev_state.hash_;
-    if (prev_state.enpassant_square_.has_value()) {
+    auto prev_ep_sq = prev_state.enpassant_square();
+    if (prev_ep_sq) {
         Bitboard ep_candidates = piece_type_bb(constants::PAWN) & color_bb(stm) &
-            lookups::pawn_attacks(*prev_state.enpassant_square_, !stm);
+            lookups::pawn_attacks(*prev_ep_sq, !stm);
         if (ep_candidates) {
-		    next_state.hash_ ^= zobrist::enpassant_key(*prev_state.enpassant_square_);
+		    next_state.hash_ ^= zobrist::enpassant_key(*prev_ep_sq);
         }
     }
 
     switch (move_type) {
         case Move::Type::NORMAL:
             move_piece(from_square, to_square, *moving_pt, stm);
-            calc_hash = false;
             next_state.hash_ ^= zobrist::piece_square_key(from_square, *moving_pt, stm);
             next_state.hash_ ^= zobrist::piece_square_key(to_square, *moving_pt, stm);
             break;
         case Move::Type::CAPTURE:
             remove_piece(to_square, *captured_pt, !stm);
             move_piece(from_square, to_square, *moving_pt, stm);
-            calc_hash = false;
             next_state.hash_ ^= zobrist::piece_square_key(to_square, *captured_pt, !stm);
             next_state.hash_ ^= zobrist::piece_square_key(from_square, *moving_pt, stm);
             next_state.hash_ ^= zobrist::piece_square_key(to_square, *moving_pt, stm);
             break;
         case Move::Type::DOUBLE_PUSH:
             move_piece(from_square, to_square, constants::PAWN, stm);
-            calc_hash = false;
             {
-                next_state.enpassant_square_ =
+                Square ep_sq =
                     stm == constants::WHITE ? Square(from_square + 8) : Square(from_square - 8);
+                next_state.set_enpassant_square(ep_sq);
                 Bitboard ep_candidates = piece_type_bb(constants::PAWN) & color_bb(!stm) &
-                    lookups::pawn_attacks(*next_state.enpassant_square_, stm);
+                    lookups::pawn_attacks(ep_sq, stm);
                 if (ep_candidates) {
-                    next_state.hash_ ^= zobrist::enpassant_key(*next_state.enpassant_square_);
+                    next_state.hash_ ^= zobrist::enpassant_key(ep_sq);
                 }
             }
             next_state.hash_ ^= zobrist::piece_square_key(from_square, constants::PAWN, stm);
             next_state.hash_ ^= zobrist::piece_square_key(to_square, constants::PAWN, stm);
             break;
-        case Move::Type::ENPASSANT:
+        case Move::Type::ENPASSANT: {
+            Square captured_sq =
+                stm == constants::WHITE ? Square(to_square - 8) : Square(to_square + 8);
             move_piece(from_square, to_square, constants::PAWN, stm);
-            remove_piece(stm == constants::WHITE ? Square(to_square - 8) : Square(to_square + 8),
-                         constants::PAWN,
-                         !stm);
+            remove_piece(captured_sq, constants::PAWN, !stm);
+            next_state.hash_ ^= zobrist::piece_square_key(from_square, constants::PAWN, stm);
+            next_state.hash_ ^= zobrist::piece_square_key(to_square, constants::PAWN, stm);
+            next_state.hash_ ^= zobrist::piece_square_key(captured_sq, constants::PAWN, !stm);
             break;
-        case Move::Type::CASTLING:
-            move_piece(from_square, to_square, constants::KING, stm);
+        }
+        case Move::Type::CASTLING: {
+            Square rook_from_square = constants::A1;
+            Square rook_to_square = constants::A1;
             switch (to_square) {
                 case constants::C1:
-                    move_piece(constants::A1, constants::D1, constants::ROOK, stm);
+                    rook_from_square = constants::A1;
+                    rook_to_square = constants::D1;
                     break;
                 case constants::G1:
-                    move_piece(constants::H1, constants::F1, constants::ROOK, stm);
+                    rook_from_square = constants::H1;
+                    rook_to_square = constants::F1;
                     break;
                 case constants::C8:
-                    move_piece(constants::A8, constants::D8, constants::ROOK, stm);
+                    rook_from_square = constants::A8;
+                    rook_to_square = constants::D8;
                     break;
                 case constants::G8:
-                    move_piece(constants::H8, constants::F8, constants::ROOK, stm);
+                    rook_from_square = constants::H8;
+                    rook_to_square = constants::F8;
                     break;
                 default:
                     break;
             }
+            move_piece(from_square, to_square, constants::KING, stm);
+            move_piece(rook_from_square, rook_to_square, constants::ROOK, stm);
+            next_state.hash_ ^= zobrist::piece_square_key(from_square, constants::KING, stm);
+            next_state.hash_ ^= zobrist::piece_square_key(to_square, constants::KING, stm);
+            next_state.hash_ ^= zobrist::piece_square_key(rook_from_square, constants::ROOK, stm);
+            next_state.hash_ ^= zobrist::piece_square_key(rook_to_square, constants::ROOK, stm);
             break;
+        }
         case Move::Type::PROMOTION:
             remove_piece(from_square, constants::PAWN, stm);
             put_piece(to_square, *promotion_pt, stm);
-	    calc_hash = false;
             next_state.hash_ ^= zobrist::piece_square_key(from_square, constants::PAWN, stm);
             next_state.hash_ ^= zobrist::piece_square_key(to_square, *promotion_pt, stm);
             break;
@@ -233,7 +263,6 @@ inline void Position::make_move(Move move) {
             remove_piece(to_square, *captured_pt, !stm);
             remove_piece(from_square, constants::PAWN, stm);
             put_piece(to_square, *promotion_pt, stm);
-	    calc_hash = false;
             next_state.hash_ ^= zobrist::piece_square_key(to_square, *captured_pt, !stm);
             next_state.hash_ ^= zobrist::piece_square_key(from_square, constants::PAWN, stm);
             next_state.hash_ ^= zobrist::piece_square_key(to_square, *promotion_pt, stm);
@@ -241,16 +270,37 @@ inline void Position::make_move(Move move) {
         case Move::Type::NONE:
             break;
     }
-    next_state.captured_pt_ = captured_pt;
+    next_state.set_captured_pt(captured_pt);
+    next_state.moved_pt_ = moving_pt->value();
     next_state.move_type_ = move_type;
-    reverse_side_to_move();
-    if (calc_hash)
-        next_state.hash_ = calculate_hash();
-    else {
-        next_state.hash_ ^= zobrist::side_to_move_key();
-        next_state.hash_ ^= zobrist::castling_rights_key(prev_state.castling_rights_);
-        next_state.hash_ ^= zobrist::castling_rights_key(next_state.castling_rights_);
+
+    next_state.pawn_hash_ = prev_state.pawn_hash_;
+    next_state.material_hash_ = prev_state.material_hash_;
+    next_state.non_pawn_material_[0] = prev_state.non_pawn_material_[0];
+    next_state.non_pawn_material_[1] = prev_state.non_pawn_material_[1];
+    next_state.phase_ = prev_state.phase_;
+    if (moving_pt == constants::PAWN) {
+        if (promotion_pt) {
+            remove_material(next_state, from_square, constants::PAWN, stm);
+            add_material(next_state, *promotion_pt, stm);
+        } else {
+            next_state.pawn_hash_ ^= zobrist::piece_square_key(from_square, constants::PAWN, stm);
+            next_state.pawn_hash_ ^= zobrist::piece_square_key(to_square, constants::PAWN, stm);
+        }
+    }
+    if (captured_pt) {
+        remove_material(next_state, to_square, *captured_pt, !stm);
+    } else if (move_type == Move::Type::ENPASSANT) {
+        remove_material(next_state, lookups::pawn_shift(to_square, !stm), constants::PAWN, !stm);
     }
+    reverse_side_to_move();
+    next_state.hash_ ^= zobrist::side_to_move_key();
+    next_state.hash_ ^= zobrist::castling_rights_key(prev_state.castling_rights());
+    next_state.hash_ ^= zobrist::castling_rights_key(next_state.castling_rights());
+    set_check_info(next_state);
+    assert(next_state.hash_ == calculate_hash());
+    assert(next_state.pawn_hash_ == calculate_pawn_hash());
+    assert(next_state.material_hash_ == calculate_material_hash());
 }
 
 inline void Position::make_null_move() {
@@ -258,23 +308,29 @@ inline void Position::make_null_move() {
     if (stm == constants::BLACK) {
         ++fullmoves_;
     }
-    ++ply_;
-    history_.push_back(State{});
+    push_state();
     State& prev = state_mut_ref(ply_ - 1);
     State& next = state_mut_ref();
     reverse_side_to_move();
-    next.previous_move_ = {};
     next.halfmoves_ = prev.halfmoves_ + 1;
+    next.plies_from_null_ = 0;
     next.castling_rights_ = prev.castling_rights_;
     next.hash_ = prev.hash_;
-    if (prev.enpassant_square_.has_value()) {
+    next.pawn_hash_ = prev.pawn_hash_;
+    next.material_hash_ = prev.material_hash_;
+    next.non_pawn_material_[0] = prev.non_pawn_material_[0];
+    next.non_pawn_material_[1] = prev.non_pawn_material_[1];
+    next.phase_ = prev.phase_;
+    auto prev_ep_sq = prev.enpassant_square();
+    if (prev_ep_sq) {
         Bitboard ep_candidates = piece_type_bb(constants::PAWN) & color_bb(stm) &
-            lookups::pawn_attacks(*prev.enpassant_square_, !stm);
+            lookups::pawn_attacks(*prev_ep_sq, !stm);
         if (ep_candidates)
-            next.hash_ ^= zobrist::enpassant_key(*prev.enpassant_square_);
+            next.hash_ ^= zobrist::enpassant_key(*prev_ep_sq);
     }
     next.hash_ ^= zobrist::side_to_move_key();
-    next.enpassant_square_ = {};
+    set_check_info(next);
+    assert(next.hash_ == calculate_hash());
 }
 
 }  // namespace libchess
@@ -92,7 +92,7 @@ inline std::string Position::uci_line() const {
     std::string result = "position " + start_fen();
     result += " moves";
     for (int p = 1; p <= ply(); ++p) {
-        auto prev_move = state(p).previous_move_;
+        auto prev_move = state(p).previous_move();
         result += " " + (prev_move ? prev_move->to_str() : "0000");
     }
     return result;
@@ -112,18 +112,27 @@ inline void Position::vflip() {
     color_bb_[0] = color_bb_[1];
     color_bb_[1] = tmp;
 
+    std::uint8_t flipped_board[64];
+    for (Square sq : constants::SQUARES) {
+        std::uint8_t piece_value = board_[sq.value()];
+        flipped_board[sq.flipped().value()] =
+            piece_value == EMPTY_SQUARE ? EMPTY_SQUARE : piece_value ^ (1 << 3);
+    }
+    std::copy(std::begin(flipped_board), std::end(flipped_board), std::begin(board_));
+
     State& curr_state = state_mut_ref();
-    if (curr_state.enpassant_square_) {
-        *curr_state.enpassant_square_ = curr_state.enpassant_square_->flipped();
+    auto ep_sq = curr_state.enpassant_square();
+    if (ep_sq) {
+        curr_state.set_enpassant_square(ep_sq->flipped());
     }
 
-    CastlingRights tmp_cr = CastlingRights{(curr_state.castling_rights_.value() & 3) << 2};
-    curr_state.castling_rights_.value_mut_ref() >>= 2;
-    curr_state.castling_rights_.value_mut_ref() ^= tmp_cr.value();
+    int castling_rights = curr_state.castling_rights().value();
+    curr_state.set_castling_rights(
+        CastlingRights{(castling_rights >> 2) ^ ((castling_rights & 3) << 2)});
 
     side_to_move_ = !side_to_move_;
 
-    state_mut_ref().hash_ = calculate_hash();
+    reset_state_keys();
 }
 
 inline std::optional<Move> Position::smallest_capture_move_to(Square square) const {
@@ -155,49 +164,194 @@ inline std::optional<Move> Position::smallest_capture_move_to(Square square) con
     return std::nullopt;
 }
 
-inline int Position::see_to(Square square, std::array<int, 6> piece_values) {
+inline int Position::see_exchange(Move move, const std::array<int, 6>& piece_values) const {
+    Color stm = side_to_move();
+    Square from_square = move.from_square();
+    Square to_square = move.to_square();
+    Bitboard occupancy = occupancy_bb() ^ Bitboard{from_square};
+    Bitboard promotion_sqs = lookups::rank_mask(constants::RANK_1) |
+                             lookups::rank_mask(constants::RANK_8);
+    int pawn_value = piece_values[constants::PAWN.value()];
+    int queen_value = piece_values[constants::QUEEN.value()];
+
+    // gain[d] is the material balance for the side making the d-th capture if it stands pat there
+    int gain[33];
+    auto captured_pt = piece_type_on(to_square);
+    if (captured_pt) {
+        gain[0] = piece_values[captured_pt->value()];
+    } else if (move_type_of(move) == Move::Type::ENPASSANT) {
+        gain[0] = pawn_value;
+        occupancy ^= Bitboard{lookups::pawn_shift(to_square, !stm)};
+    } else {
+        gain[0] = 0;
+    }
+    int attacker_value = piece_values[piece_type_on(from_square)->value()];
+    auto promotion_pt = move.promotion_piece_type();
+    if (promotion_pt) {
+        gain[0] += piece_values[promotion_pt->value()] - pawn_value;
+        attacker_value = piece_values[promotion_pt->value()];
+    }
+
+    Bitboard bishops_queens = piece_type_bb(constants::BISHOP) | piece_type_bb(constants::QUEEN);
+    Bitboard rooks_queens = piece_type_bb(constants::ROOK) | piece_type_bb(constants::QUEEN);
+    Bitboard attackers = attackers_to(to_square, occupancy) & occupancy;
+    Color side = !stm;
+    int depth = 0;
+    while (true) {
+        Bitboard side_attackers = attackers & color_bb(side);
+        if (!side_attackers) {
+            break;
+        }
+        PieceType pt = constants::PAWN;
+        Bitboard pt_attackers;
+        for (; pt <= constants::KING; ++pt) {
+            pt_attackers = side_attackers & piece_type_bb(pt);
+            if (pt_attackers) {
+                break;
+            }
+        }
+        // The king may only take last, when the square is no longer defended
+        if (pt == constants::KING && (attackers & color_bb(!side))) {
+            break;
+        }
+
+        ++depth;
+        gain[depth] = attacker_value - gain[depth - 1];
+        attacker_value = piece_values[pt.value()];
+        if (pt == constants::PAWN && (Bitboard{to_square} & promotion_sqs)) {
+            gain[depth] += queen_value - pawn_value;
+            attacker_value = queen_value;
+        }
+
+        // Removing the attacker may uncover a slider behind it
+        occupancy ^= Bitboard{pt_attackers.forward_bitscan()};
+        if (pt == constants::PAWN || pt == constants::BISHOP || pt == constants::QUEEN) {
+            attackers |= lookups::bishop_attacks(to_square, occupancy) & bishops_queens;
+        }
+        if (pt == constants::ROOK || pt == constants::QUEEN) {
+            attackers |= lookups::rook_attacks(to_square, occupancy) & rooks_queens;
+        }
+        attackers &= occupancy;
+        side = !side;
+    }
+
+    // Each side may decline to recapture, so fold the list back with a negamax
+    for (; depth > 0; --depth) {
+        gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+    }
+    return gain[0];
+}
+
+inline int Position::see_to(Square square, std::array<int, 6> piece_values) const {
     auto smallest_capture_move = smallest_capture_move_to(square);
     if (!smallest_capture_move) {
         return 0;
     }
     bool is_enpassant = smallest_capture_move->type() == Move::Type::ENPASSANT;
-
-    auto square_pt = piece_on(square);
-    if (!square_pt && !is_enpassant) {
+    if (!piece_on(square) && !is_enpassant) {
         return 0;
     }
+    return std::max(0, see_exchange(*smallest_capture_move, piece_values));
+}
 
-    int piece_val = is_enpassant ? piece_values.at(0) : piece_values.at(square_pt->type().value());
-    auto smallest_capture_move_prom_piece_type = smallest_capture_move->promotion_piece_type();
-    if (smallest_capture_move_prom_piece_type) {
-        piece_val +=
-            piece_values.at(smallest_capture_move_prom_piece_type->value()) - piece_values.at(0);
+inline int Position::see_for(Move move, std::array<int, 6> piece_values) const {
+    bool is_enpassant = move_type_of(move) == Move::Type::ENPASSANT;
+    if (!piece_on(move.to_square()) && !is_enpassant) {
+        return 0;
     }
-    Position pos = *this;
-    pos.make_move(*smallest_capture_move);
-    return std::max(0, piece_val - pos.see_to(square, piece_values));
+    return std::max(0, see_exchange(move, piece_values));
 }
 
-inline int Position::see_for(Move move, std::array<int, 6> piece_values) {
-    bool is_enpassant = move_type_of(move) == Move::Type::ENPASSANT;
+inline bool Position::see_ge(Move move, int threshold, std::array<int, 6> piece_values) const {
+    Move::Type move_type = move_type_of(move);
+    if (move_type == Move::Type::CASTLING) {
+        return 0 >= threshold;
+    }
 
-    auto square_pt = piece_on(move.to_square());
-    if (!square_pt && !is_enpassant) {
-        return 0;
+    Color stm = side_to_move();
+    Square from_square = move.from_square();
+    Square to_square = move.to_square();
+    Bitboard occupancy = occupancy_bb() ^ Bitboard{from_square} ^ Bitboard{to_square};
+
+    int captured_value = 0;
+    auto captured_pt = piece_type_on(to_square);
+    if (captured_pt) {
+        captured_value = piece_values[captured_pt->value()];
+    } else if (move_type == Move::Type::ENPASSANT) {
+        captured_value = piece_values[constants::PAWN.value()];
+        occupancy ^= Bitboard{lookups::pawn_shift(to_square, !stm)};
+    }
+    int moving_value = piece_values[piece_type_on(from_square)->value()];
+    auto promotion_pt = move.promotion_piece_type();
+    if (promotion_pt) {
+        captured_value +=
+            piece_values[promotion_pt->value()] - piece_values[constants::PAWN.value()];
+        moving_value = piece_values[promotion_pt->value()];
     }
 
-    int piece_val = is_enpassant ? piece_values.at(0) : piece_values.at(square_pt->type().value());
-    auto move_prom_piece_type = move.promotion_piece_type();
-    if (move_prom_piece_type) {
-        piece_val += piece_values.at(move_prom_piece_type->value()) - piece_values.at(0);
+    // A pawn recapturing on the back rank promotes, which the swap below can't express, so those
+    // exchanges are resolved by the full swap list to agree with see_for
+    Bitboard promotion_sqs = lookups::rank_mask(constants::RANK_1) |
+                             lookups::rank_mask(constants::RANK_8);
+    if ((Bitboard{to_square} & promotion_sqs) &&
+        (attackers_to(to_square, occupancy) & occupancy & piece_type_bb(constants::PAWN))) {
+        return see_exchange(move, piece_values) >= threshold;
+    }
+
+    // swap is what the side to move stands to lose beyond the threshold if the exchange continues
+    int swap = captured_value - threshold;
+    if (swap < 0) {
+        return false;
+    }
+    swap = moving_value - swap;
+    if (swap <= 0) {
+        return true;
+    }
+
+    Bitboard bishops_queens = piece_type_bb(constants::BISHOP) | piece_type_bb(constants::QUEEN);
+    Bitboard rooks_queens = piece_type_bb(constants::ROOK) | piece_type_bb(constants::QUEEN);
+    Bitboard attackers = attackers_to(to_square, occupancy);
+    Color side = stm;
+    int res = 1;
+    while (true) {
+        side = !side;
+        attackers &= occupancy;
+        Bitboard side_attackers = attackers & color_bb(side);
+        if (!side_attackers) {
+            break;
+        }
+        res ^= 1;
+
+        PieceType pt = constants::PAWN;
+        Bitboard pt_attackers;
+        for (; pt <= constants::KING; ++pt) {
+            pt_attackers = side_attackers & piece_type_bb(pt);
+            if (pt_attackers) {
+                break;
+            }
+        }
+        if (pt == constants::KING) {
+            // Taking with the king only stands if the opponent has nothing left to recapture
+            return (attackers & ~color_bb(side)) ? res ^ 1 : res;
+        }
+        swap = piece_values[pt.value()] - swap;
+        if (swap < res) {
+            break;
+        }
+        occupancy ^= Bitboard{pt_attackers.forward_bitscan()};
+        if (pt == constants::PAWN || pt == constants::BISHOP || pt == constants::QUEEN) {
+            attackers |= lookups::bishop_attacks(to_square, occupancy) & bishops_queens;
+        }
+        if (pt == constants::ROOK || pt == constants::QUEEN) {
+            attackers |= lookups::rook_attacks(to_square, occupancy) & rooks_queens;
+        }
     }
-    Position pos = *this;
-    pos.make_move(move);
-    return std::max(0, piece_val - pos.see_to(move.to_square(), piece_values));
+    return res != 0;
 }
 
 inline std::optional<Position> Position::from_fen(const std::string& fen) {
     Position pos;
+    pos.reserve_history();
     pos.history_.push_back(State{});
     State& curr_state = pos.state_mut_ref();
 
@@ -227,11 +381,11 @@ inline std::optional<Position> Position::from_fen(const std::string& fen) {
 
     // Castling rights
     fen_stream >> fen_part;
-    curr_state.castling_rights_ = CastlingRights::from(fen_part);
+    curr_state.set_castling_rights(CastlingRights::from(fen_part));
 
     // Enpassant square
     fen_stream >> fen_part;
-    curr_state.enpassant_square_ = Square::from(fen_part);
+    curr_state.set_enpassant_square(Square::from(fen_part));
 
     // Halfmoves
     fen_stream >> fen_part;
@@ -244,7 +398,7 @@ inline std::optional<Position> Position::from_fen(const std::string& fen) {
     fen_part_cstr = fen_part.c_str();
     pos.fullmoves_ = std::strtol(fen_part_cstr, &end, 10);
 
-    pos.state_mut_ref().hash_ = pos.calculate_hash();
+    pos.reset_state_keys();
     pos.start_fen_ = fen;
     return pos;
 }
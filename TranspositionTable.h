@@ -0,0 +1,195 @@
+#ifndef LIBCHESS_TRANSPOSITIONTABLE_H
+#define LIBCHESS_TRANSPOSITIONTABLE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "Move.h"
+#include "Position.h"
+#include "UCIOption.h"
+
+namespace libchess {
+
+// A transposition table that search threads share without locks. Entries are grouped four to a
+// cache-line bucket. Each slot stores its key XORed with its data word, so a slot torn by racing
+// writers fails verification and reads as a miss instead of returning another position's data.
+// Within a bucket the shallowest and oldest entry is replaced first. Resizing and clearing are not
+// synchronized and must only happen while no search is running.
+class TranspositionTable {
+   public:
+    using hash_type = Position::hash_type;
+
+    enum class Bound : std::uint8_t
+    {
+        NONE,
+        UPPER,
+        LOWER,
+        EXACT
+    };
+
+    struct Entry {
+        // Only from, to and promotion are kept, so the move comes back with Move::Type::NONE
+        Move move;
+        int score;
+        int depth;
+        Bound bound;
+    };
+
+    constexpr static int DEFAULT_SIZE_MB = 16;
+    constexpr static int MAX_SIZE_MB = 65536;
+
+    explicit TranspositionTable(int size_mb = DEFAULT_SIZE_MB) {
+        resize(size_mb);
+    }
+
+    void resize(int size_mb) {
+        size_mb = std::clamp(size_mb, 1, MAX_SIZE_MB);
+        std::size_t num_buckets = 1;
+        while (num_buckets * 2 * sizeof(Bucket) <= std::size_t(size_mb) * 1024 * 1024) {
+            num_buckets *= 2;
+        }
+        buckets_ = std::vector<Bucket>(num_buckets);
+        mask_ = num_buckets - 1;
+        size_mb_ = size_mb;
+        generation_ = 0;
+    }
+    void clear() {
+        for (Bucket& bucket : buckets_) {
+            for (Slot& slot : bucket.slots) {
+                slot.key_xor_data.store(0, std::memory_order_relaxed);
+                slot.data.store(0, std::memory_order_relaxed);
+            }
+        }
+        generation_ = 0;
+    }
+    // Ages every entry by one search, making it preferred for replacement
+    void new_search() {
+        generation_ = (generation_ + 1) & GENERATION_MASK;
+    }
+
+    void prefetch(hash_type hash) const {
+        __builtin_prefetch(&buckets_[hash & mask_]);
+    }
+
+    std::optional<Entry> probe(hash_type hash) const {
+        const Bucket& bucket = buckets_[hash & mask_];
+        for (const Slot& slot : bucket.slots) {
+            std::uint64_t data = slot.data.load(std::memory_order_relaxed);
+            if ((data & OCCUPIED_BIT) &&
+                (slot.key_xor_data.load(std::memory_order_relaxed) ^ data) == hash) {
+                return unpack(data);
+            }
+        }
+        return std::nullopt;
+    }
+
+    void store(hash_type hash, Move move, int score, int depth, Bound bound) {
+        Bucket& bucket = buckets_[hash & mask_];
+        Slot* victim = &bucket.slots[0];
+        int victim_worth = worth_of(bucket.slots[0].data.load(std::memory_order_relaxed));
+        for (Slot& slot : bucket.slots) {
+            std::uint64_t data = slot.data.load(std::memory_order_relaxed);
+            bool is_match = (data & OCCUPIED_BIT) &&
+                            (slot.key_xor_data.load(std::memory_order_relaxed) ^ data) == hash;
+            if (is_match || !(data & OCCUPIED_BIT)) {
+                // Keep the known best move when the new result has none
+                if (is_match && move.value() == 0) {
+                    move = unpack(data).move;
+                }
+                victim = &slot;
+                break;
+            }
+            int worth = worth_of(data);
+            if (worth < victim_worth) {
+                victim = &slot;
+                victim_worth = worth;
+            }
+        }
+
+        std::uint64_t data = pack(move, score, depth, bound);
+        victim->key_xor_data.store(hash ^ data, std::memory_order_relaxed);
+        victim->data.store(data, std::memory_order_relaxed);
+    }
+
+    // Permille of a sample of slots written during the current search, as reported by UCI hashfull
+    int hashfull() const {
+        std::size_t num_sampled_buckets = std::min<std::size_t>(buckets_.size(), 250);
+        int used = 0;
+        for (std::size_t i = 0; i < num_sampled_buckets; ++i) {
+            for (const Slot& slot : buckets_[i].slots) {
+                std::uint64_t data = slot.data.load(std::memory_order_relaxed);
+                if ((data & OCCUPIED_BIT) && unpack_generation(data) == generation_) {
+                    ++used;
+                }
+            }
+        }
+        return used * 1000 / int(num_sampled_buckets * SLOTS_PER_BUCKET);
+    }
+
+    int size_mb() const {
+        return size_mb_;
+    }
+    // The UCI "Hash" option, resizing this table when set
+    UCISpinOption uci_option() {
+        return UCISpinOption{"Hash", size_mb_, 1, MAX_SIZE_MB, [this](const int& size_mb) {
+                                 resize(size_mb);
+                             }};
+    }
+
+   private:
+    constexpr static int SLOTS_PER_BUCKET = 4;
+    constexpr static int GENERATION_MASK = 0x3f;
+
+    // Data word layout: move (16) | score (16) | depth (8) | bound (2) | generation (6) | occupied
+    constexpr static int SCORE_SHIFT = 16;
+    constexpr static int DEPTH_SHIFT = 32;
+    constexpr static int BOUND_SHIFT = 40;
+    constexpr static int GENERATION_SHIFT = 42;
+    constexpr static std::uint64_t OCCUPIED_BIT = std::uint64_t(1) << 63;
+
+    struct Slot {
+        std::atomic<std::uint64_t> key_xor_data{0};
+        std::atomic<std::uint64_t> data{0};
+    };
+    struct alignas(64) Bucket {
+        Slot slots[SLOTS_PER_BUCKET];
+    };
+    static_assert(sizeof(Bucket) == 64);
+
+    std::uint64_t pack(Move move, int score, int depth, Bound bound) const {
+        auto score_bits = std::uint16_t(std::int16_t(std::clamp(score, -32768, 32767)));
+        auto depth_bits = std::uint8_t(std::int8_t(std::clamp(depth, -128, 127)));
+        return std::uint64_t(move.value_sans_type() & 0xffff) |
+               (std::uint64_t(score_bits) << SCORE_SHIFT) |
+               (std::uint64_t(depth_bits) << DEPTH_SHIFT) |
+               (std::uint64_t(bound) << BOUND_SHIFT) |
+               (std::uint64_t(generation_) << GENERATION_SHIFT) | OCCUPIED_BIT;
+    }
+    static Entry unpack(std::uint64_t data) {
+        return Entry{Move{std::uint32_t(data & 0xffff)},
+                     std::int16_t(std::uint16_t(data >> SCORE_SHIFT)),
+                     std::int8_t(std::uint8_t(data >> DEPTH_SHIFT)),
+                     Bound((data >> BOUND_SHIFT) & 3)};
+    }
+    static int unpack_generation(std::uint64_t data) {
+        return int((data >> GENERATION_SHIFT) & GENERATION_MASK);
+    }
+    // Replacement priority: deep entries from the current search are kept longest
+    int worth_of(std::uint64_t data) const {
+        int age = (generation_ - unpack_generation(data)) & GENERATION_MASK;
+        return unpack(data).depth - 8 * age;
+    }
+
+    std::vector<Bucket> buckets_;
+    std::size_t mask_ = 0;
+    int size_mb_ = 0;
+    int generation_ = 0;
+};
+
+}  // namespace libchess
+
+#endif  // LIBCHESS_TRANSPOSITIONTABLE_H
@@ -0,0 +1,467 @@
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "../PolyglotBook.h"
+
+using namespace libchess;
+
+// Builds a Polyglot book from a stream of games, one per line, each a result token (1-0, 0-1,
+// 1/2-1/2 or *) followed by the moves from the start position in UCI notation:
+//
+//     1-0 e2e4 e7e5 g1f3 b8c6 f1b5
+//
+// Every move played within the first --max-ply plies is recorded as a (key, move, weight) record,
+// weighted 2 for a win and 1 for a draw of the side that played it. Worker threads replay games
+// into their own record buffers. A full buffer is sorted, its duplicates summed, and spilled to a
+// run file, so --memory bounds the total buffer size no matter how large the input is. The runs
+// are then merged into the book.
+
+namespace {
+
+struct BookRecord {
+    std::uint64_t key;
+    std::uint16_t move;
+    std::uint32_t weight;
+
+    bool operator<(const BookRecord& rhs) const {
+        return key < rhs.key || (key == rhs.key && move < rhs.move);
+    }
+};
+
+struct BuilderOptions {
+    std::string output_path = "book.bin";
+    int max_ply = 24;
+    int num_threads = 1;
+    int memory_mb = 1024;
+};
+
+// Hands batches of input lines from the reading thread to the workers, with a bounded backlog
+class BatchQueue {
+   public:
+    explicit BatchQueue(std::size_t max_batches) : max_batches_(max_batches) {
+    }
+
+    void push(std::vector<std::string> batch) {
+        std::unique_lock<std::mutex> lock{mutex_};
+        not_full_.wait(lock, [&] { return batches_.size() < max_batches_; });
+        batches_.push_back(std::move(batch));
+        not_empty_.notify_one();
+    }
+    bool pop(std::vector<std::string>& batch) {
+        std::unique_lock<std::mutex> lock{mutex_};
+        not_empty_.wait(lock, [&] { return !batches_.empty() || closed_; });
+        if (batches_.empty()) {
+            return false;
+        }
+        batch = std::move(batches_.front());
+        batches_.pop_front();
+        not_full_.notify_one();
+        return true;
+    }
+    void close() {
+        std::lock_guard<std::mutex> lock{mutex_};
+        closed_ = true;
+        not_empty_.notify_all();
+    }
+
+   private:
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::deque<std::vector<std::string>> batches_;
+    std::size_t max_batches_;
+    bool closed_ = false;
+};
+
+// Sorts the records and sums the weights of identical (key, move) pairs in place
+void sort_and_combine(std::vector<BookRecord>& records) {
+    std::sort(records.begin(), records.end());
+    std::size_t size = 0;
+    for (const BookRecord& record : records) {
+        if (size > 0 && records[size - 1].key == record.key &&
+            records[size - 1].move == record.move) {
+            records[size - 1].weight += record.weight;
+        } else {
+            records[size++] = record;
+        }
+    }
+    records.resize(size);
+}
+
+// Run files hold the record fields back to back in native byte order, without struct padding
+constexpr std::size_t RUN_RECORD_SIZE =
+    sizeof(BookRecord::key) + sizeof(BookRecord::move) + sizeof(BookRecord::weight);
+
+void write_record(std::ofstream& file, const BookRecord& record) {
+    char bytes[RUN_RECORD_SIZE];
+    std::memcpy(bytes, &record.key, sizeof(record.key));
+    std::memcpy(bytes + 8, &record.move, sizeof(record.move));
+    std::memcpy(bytes + 10, &record.weight, sizeof(record.weight));
+    file.write(bytes, RUN_RECORD_SIZE);
+}
+
+// Returns false at the end of the run; a truncated record or a failed read also sets the badbit
+bool read_record(std::ifstream& file, BookRecord& record) {
+    char bytes[RUN_RECORD_SIZE];
+    if (!file.read(bytes, RUN_RECORD_SIZE)) {
+        if (file.gcount() != 0) {
+            file.setstate(std::ios::badbit);
+        }
+        return false;
+    }
+    std::memcpy(&record.key, bytes, sizeof(record.key));
+    std::memcpy(&record.move, bytes + 8, sizeof(record.move));
+    std::memcpy(&record.weight, bytes + 10, sizeof(record.weight));
+    return true;
+}
+
+class RunWriter {
+   public:
+    explicit RunWriter(std::string prefix) : prefix_(std::move(prefix)) {
+    }
+
+    // Writes the sorted records to a new run file and returns false on I/O failure, in which case
+    // the partial file is removed
+    bool write(const std::vector<BookRecord>& records) {
+        std::string path = new_path();
+        std::ofstream file{path, std::ios::binary};
+        for (const BookRecord& record : records) {
+            write_record(file, record);
+        }
+        file.close();
+        if (!file) {
+            std::remove(path.c_str());
+            return false;
+        }
+        return true;
+    }
+    // Names a new run file and remembers it for cleanup
+    std::string new_path() {
+        std::string path = prefix_ + std::to_string(next_run_++);
+        std::lock_guard<std::mutex> lock{mutex_};
+        paths_.push_back(path);
+        return path;
+    }
+    // Every run file named so far, including failed and intermediate ones
+    const std::vector<std::string>& paths() const {
+        return paths_;
+    }
+
+   private:
+    std::string prefix_;
+    std::atomic<int> next_run_{0};
+    std::mutex mutex_;
+    std::vector<std::string> paths_;
+};
+
+// Replays a game from start_pos in pos, which the caller keeps across games so that its history
+// is allocated once per worker
+void record_game(const std::string& line,
+                 int max_ply,
+                 const Position& start_pos,
+                 Position& pos,
+                 std::vector<BookRecord>& records) {
+    std::istringstream line_stream{line};
+    std::string token;
+    if (!(line_stream >> token)) {
+        return;
+    }
+    // Weights for white and black
+    std::uint32_t weights[2];
+    if (token == "1-0") {
+        weights[0] = 2, weights[1] = 0;
+    } else if (token == "0-1") {
+        weights[0] = 0, weights[1] = 2;
+    } else if (token == "1/2-1/2") {
+        weights[0] = 1, weights[1] = 1;
+    } else {
+        return;
+    }
+
+    pos = start_pos;
+    for (int ply = 0; ply < max_ply && line_stream >> token; ++ply) {
+        auto move = Move::from(token);
+        if (!move || !pos.is_legal_move(*move)) {
+            return;
+        }
+        std::uint32_t weight = weights[pos.side_to_move().value()];
+        if (weight > 0) {
+            records.push_back(BookRecord{pos.hash(), polyglot::encode_move(*move, pos), weight});
+        }
+        pos.make_move(*move);
+    }
+}
+
+void write_big_endian(std::ofstream& file, std::uint64_t value, int num_bytes) {
+    for (int i = num_bytes - 1; i >= 0; --i) {
+        file.put(char((value >> (8 * i)) & 0xff));
+    }
+}
+
+// Writes the moves of one position heaviest first, scaling the weights down into 16 bits
+void write_position(std::ofstream& file, std::vector<BookRecord>& position_records) {
+    std::sort(position_records.begin(), position_records.end(),
+              [](const BookRecord& lhs, const BookRecord& rhs) { return lhs.weight > rhs.weight; });
+    std::uint32_t max_weight = position_records.front().weight;
+    for (const BookRecord& record : position_records) {
+        std::uint64_t weight = record.weight;
+        if (max_weight > 0xffff) {
+            weight = std::max<std::uint64_t>(1, weight * 0xffff / max_weight);
+        }
+        write_big_endian(file, record.key, 8);
+        write_big_endian(file, record.move, 2);
+        write_big_endian(file, weight, 2);
+        write_big_endian(file, 0, 4);
+    }
+    position_records.clear();
+}
+
+// Streams the records of several sorted runs in order, summing the weights of a (key, move) pair
+// spread over several runs. A run that fails to open or read fails the merge rather than silently
+// dropping its weights.
+class RunMerger {
+   public:
+    bool open(const std::vector<std::string>& run_paths) {
+        cursors_ = std::vector<RunCursor>(run_paths.size());
+        for (std::size_t i = 0; i < run_paths.size(); ++i) {
+            cursors_[i].file.open(run_paths[i], std::ios::binary);
+            if (!cursors_[i].file) {
+                failed_ = true;
+                return false;
+            }
+            advance(i);
+        }
+        return !failed_;
+    }
+    bool next(BookRecord& record) {
+        if (heap_.empty() || failed_) {
+            return false;
+        }
+        record = pop();
+        while (!heap_.empty() && cursors_[heap_.top()].record.key == record.key &&
+               cursors_[heap_.top()].record.move == record.move) {
+            record.weight += pop().weight;
+        }
+        return true;
+    }
+    bool failed() const {
+        return failed_;
+    }
+
+   private:
+    struct RunCursor {
+        std::ifstream file;
+        BookRecord record;
+    };
+    struct Greater {
+        const std::vector<RunCursor>* cursors;
+
+        bool operator()(std::size_t lhs, std::size_t rhs) const {
+            return (*cursors)[rhs].record < (*cursors)[lhs].record;
+        }
+    };
+
+    void advance(std::size_t run) {
+        if (read_record(cursors_[run].file, cursors_[run].record)) {
+            heap_.push(run);
+        } else if (cursors_[run].file.bad()) {
+            failed_ = true;
+        }
+    }
+    BookRecord pop() {
+        std::size_t run = heap_.top();
+        heap_.pop();
+        BookRecord record = cursors_[run].record;
+        advance(run);
+        return record;
+    }
+
+    std::vector<RunCursor> cursors_;
+    std::priority_queue<std::size_t, std::vector<std::size_t>, Greater> heap_{Greater{&cursors_}};
+    bool failed_ = false;
+};
+
+// Merges at most this many runs at once, to stay well below the open file limit
+constexpr std::size_t MAX_MERGE_FAN_IN = 64;
+
+bool merge_into_run(const std::vector<std::string>& run_paths, const std::string& output_path) {
+    RunMerger merger;
+    if (!merger.open(run_paths)) {
+        return false;
+    }
+    std::ofstream output{output_path, std::ios::binary};
+    BookRecord record;
+    while (merger.next(record)) {
+        write_record(output, record);
+    }
+    output.close();
+    return !merger.failed() && output;
+}
+
+// Merges the runs into the book, first combining them in passes of MAX_MERGE_FAN_IN runs into
+// intermediate runs until few enough are left. Returns false on any I/O failure.
+bool merge_runs(std::vector<std::string> run_paths,
+                RunWriter& run_writer,
+                const std::string& output_path,
+                std::size_t& num_entries) {
+    while (run_paths.size() > MAX_MERGE_FAN_IN) {
+        std::vector<std::string> merged_paths;
+        for (std::size_t begin = 0; begin < run_paths.size(); begin += MAX_MERGE_FAN_IN) {
+            std::size_t end = std::min(begin + MAX_MERGE_FAN_IN, run_paths.size());
+            std::vector<std::string> group(run_paths.begin() + begin, run_paths.begin() + end);
+            std::string merged_path = run_writer.new_path();
+            if (!merge_into_run(group, merged_path)) {
+                return false;
+            }
+            for (const std::string& path : group) {
+                std::remove(path.c_str());
+            }
+            merged_paths.push_back(merged_path);
+        }
+        run_paths = std::move(merged_paths);
+    }
+
+    RunMerger merger;
+    if (!merger.open(run_paths)) {
+        return false;
+    }
+    std::ofstream output{output_path, std::ios::binary};
+    std::vector<BookRecord> position_records;
+    num_entries = 0;
+    BookRecord record;
+    while (merger.next(record)) {
+        if (!position_records.empty() && position_records.back().key != record.key) {
+            num_entries += position_records.size();
+            write_position(output, position_records);
+        }
+        position_records.push_back(record);
+    }
+    if (!position_records.empty()) {
+        num_entries += position_records.size();
+        write_position(output, position_records);
+    }
+    output.close();
+    return !merger.failed() && output;
+}
+
+bool parse_options(int argc, char** argv, BuilderOptions& options) {
+    if (argc % 2 == 0) {
+        return false;
+    }
+    for (int i = 1; i < argc; i += 2) {
+        std::string_view name = argv[i];
+        const char* value = argv[i + 1];
+        if (name == "--output") {
+            options.output_path = value;
+        } else if (name == "--max-ply") {
+            options.max_ply = std::max(1, std::atoi(value));
+        } else if (name == "--threads") {
+            options.num_threads = std::max(1, std::atoi(value));
+        } else if (name == "--memory") {
+            options.memory_mb = std::max(1, std::atoi(value));
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    BuilderOptions options;
+    if (!parse_options(argc, argv, options)) {
+        std::cerr << "Usage: ./book_builder [--output <book.bin>] [--max-ply <n>] "
+                     "[--threads <n>] [--memory <mb>] < games.txt\n";
+        return 1;
+    }
+
+    // The memory budget is split evenly between the workers' record buffers
+    std::size_t buffer_capacity =
+        std::max(std::size_t(options.memory_mb) * 1024 * 1024 / sizeof(BookRecord) /
+                     std::size_t(options.num_threads),
+                 std::size_t(options.max_ply) * 2);
+    constexpr std::size_t BATCH_SIZE = 1024;
+    BatchQueue queue{std::size_t(options.num_threads) * 4};
+    RunWriter run_writer{options.output_path + ".run"};
+    std::atomic<std::size_t> num_games{0};
+    std::atomic<bool> failed{false};
+
+    const Position start_pos{constants::STARTPOS_FEN};
+    auto worker = [&]() {
+        Position pos = start_pos;
+        std::vector<BookRecord> records;
+        records.reserve(buffer_capacity);
+        std::vector<std::string> batch;
+        while (queue.pop(batch)) {
+            for (const std::string& line : batch) {
+                record_game(line, options.max_ply, start_pos, pos, records);
+                // A game adds at most max_ply records, so spill before the next one could overflow
+                if (records.size() + options.max_ply > buffer_capacity) {
+                    sort_and_combine(records);
+                    if (!run_writer.write(records)) {
+                        failed = true;
+                    }
+                    records.clear();
+                }
+            }
+            num_games += batch.size();
+        }
+        if (!records.empty()) {
+            sort_and_combine(records);
+            if (!run_writer.write(records)) {
+                failed = true;
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int i = 0; i < options.num_threads; ++i) {
+        threads.emplace_back(worker);
+    }
+
+    std::vector<std::string> batch;
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        batch.push_back(std::move(line));
+        if (batch.size() == BATCH_SIZE) {
+            queue.push(std::move(batch));
+            batch.clear();
+        }
+    }
+    if (!batch.empty()) {
+        queue.push(std::move(batch));
+    }
+    queue.close();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<std::string> run_paths = run_writer.paths();
+    std::size_t num_entries = 0;
+    bool is_written =
+        !failed && merge_runs(run_paths, run_writer, options.output_path, num_entries);
+    for (const std::string& path : run_writer.paths()) {
+        std::remove(path.c_str());
+    }
+    if (!is_written) {
+        std::cerr << "Failed to write " << options.output_path << "\n";
+        return 1;
+    }
+    std::cout << "Games: " << num_games << ", runs: " << run_paths.size()
+              << ", entries: " << num_entries << "\n";
+    return 0;
+}
@@ -0,0 +1,101 @@
+#ifndef LIBCHESS_CUCKOO_H
+#define LIBCHESS_CUCKOO_H
+
+#include <array>
+#include <cstdint>
+
+#include "../Lookups.h"
+#include "../Move.h"
+#include "Zobrist.h"
+
+// Cuckoo tables of the hash differences of every reversible move (a non-pawn piece moving between
+// two squares on an empty board, side to move flipped), after Marcel van Kervinck's cycle
+// detection. A hash difference found in the table means one move transposes between the positions.
+namespace libchess::cuckoo {
+
+constexpr static int SIZE = 8192;
+
+constexpr inline int h1(std::uint64_t key) {
+    return int(key & 0x1fff);
+}
+constexpr inline int h2(std::uint64_t key) {
+    return int((key >> 16) & 0x1fff);
+}
+
+struct Tables {
+    std::array<std::uint64_t, SIZE> keys{};
+    std::array<Move, SIZE> moves{};
+};
+
+namespace init {
+
+constexpr inline Bitboard empty_board_attacks(PieceType piece_type, Square square) {
+    switch (piece_type.value()) {
+        case PieceType::Value::KNIGHT:
+            return lookups::knight_attacks(square);
+        case PieceType::Value::BISHOP:
+            return lookups::bishop_attacks(square);
+        case PieceType::Value::ROOK:
+            return lookups::rook_attacks(square);
+        case PieceType::Value::QUEEN:
+            return lookups::queen_attacks(square);
+        default:
+            return lookups::king_attacks(square);
+    }
+}
+
+constexpr inline Tables tables() {
+    Tables tables{};
+    for (Color c : constants::COLORS) {
+        for (PieceType pt = constants::KNIGHT; pt <= constants::KING; ++pt) {
+            for (Square s1 = constants::A1; s1 <= constants::H8; ++s1) {
+                for (Square s2 = s1 + 1; s2 <= constants::H8; ++s2) {
+                    if (!(empty_board_attacks(pt, s1) & Bitboard{s2})) {
+                        continue;
+                    }
+                    std::uint64_t key = zobrist::piece_square_key(s1, pt, c) ^
+                                        zobrist::piece_square_key(s2, pt, c) ^
+                                        zobrist::side_to_move_key();
+                    Move move{s1, s2};
+                    // Kick out whatever occupies the slot and move it to its other slot until
+                    // an empty one is reached
+                    int i = h1(key);
+                    while (true) {
+                        std::uint64_t kicked_key = tables.keys[i];
+                        Move kicked_move = tables.moves[i];
+                        tables.keys[i] = key;
+                        tables.moves[i] = move;
+                        if (kicked_move == Move{}) {
+                            break;
+                        }
+                        key = kicked_key;
+                        move = kicked_move;
+                        i = i == h1(key) ? h2(key) : h1(key);
+                    }
+                }
+            }
+        }
+    }
+    return tables;
+}
+
+}  // namespace init
+
+constexpr static Tables TABLES = init::tables();
+
+// The reversible move whose hash difference is move_key, if there is one
+constexpr inline const Move* lookup(std::uint64_t move_key) {
+    int i = h1(move_key);
+    if (TABLES.keys[i] == move_key) {
+        return &TABLES.moves[i];
+    }
+    i = h2(move_key);
+    if (TABLES.keys[i] == move_key) {
+        return &TABLES.moves[i];
+    }
+    return nullptr;
+}
+
+}  // namespace libchess::cuckoo
+
+#endif  // LIBCHESS_CUCKOO_H
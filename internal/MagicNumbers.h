@@ -0,0 +1,78 @@
+#ifndef LIBCHESS_MAGICNUMBERS_H
+#define LIBCHESS_MAGICNUMBERS_H
+
+#include <cstdint>
+
+namespace libchess::magics {
+
+constexpr static std::uint64_t bishop_magics[64] = {
+    std::uint64_t(0x0040110801044180), std::uint64_t(0x4984040444102500),
+    std::uint64_t(0x00320C0401242810), std::uint64_t(0x0004410020008800),
+    std::uint64_t(0x0104042200246840), std::uint64_t(0x0003040340800000),
+    std::uint64_t(0x0802840528404010), std::uint64_t(0x264080280202208A),
+    std::uint64_t(0x0000400224540080), std::uint64_t(0x0000200414208029),
+    std::uint64_t(0x0520100902057A00), std::uint64_t(0x0809080A00200900),
+    std::uint64_t(0x1040440308000042), std::uint64_t(0x0000020105202140),
+    std::uint64_t(0x0510095C02084148), std::uint64_t(0x8000208200822000),
+    std::uint64_t(0x00C0083114388080), std::uint64_t(0x0010813210020088),
+    std::uint64_t(0x0004000800202200), std::uint64_t(0x1012001040104004),
+    std::uint64_t(0x040C0002021A0060), std::uint64_t(0x0002001B05008200),
+    std::uint64_t(0x8010800044046000), std::uint64_t(0x0800209086080220),
+    std::uint64_t(0x82042413A0385000), std::uint64_t(0x4044600010010900),
+    std::uint64_t(0x0002020C44440402), std::uint64_t(0x1008080000202120),
+    std::uint64_t(0x00C0840010802000), std::uint64_t(0x0408049002004404),
+    std::uint64_t(0x4A88820000881400), std::uint64_t(0xC244009028220520),
+    std::uint64_t(0x02C4840488202000), std::uint64_t(0x0404300822020212),
+    std::uint64_t(0x02B2042E00100080), std::uint64_t(0x0200600800050051),
+    std::uint64_t(0x1204180200902008), std::uint64_t(0x0010005600804104),
+    std::uint64_t(0x2084A80448220110), std::uint64_t(0x002A028102012400),
+    std::uint64_t(0x0801100904042000), std::uint64_t(0x03004210840010A4),
+    std::uint64_t(0x1042001404025A04), std::uint64_t(0x8708004208000080),
+    std::uint64_t(0x08C282020A054400), std::uint64_t(0x0004008802020040),
+    std::uint64_t(0x02500220D400A100), std::uint64_t(0x0414010401088220),
+    std::uint64_t(0x8620820120214008), std::uint64_t(0x0012004208042004),
+    std::uint64_t(0x0040118448082004), std::uint64_t(0x4488080042022004),
+    std::uint64_t(0x0000004005010100), std::uint64_t(0x0000500210410902),
+    std::uint64_t(0x0010028808008000), std::uint64_t(0x0820024408428046),
+    std::uint64_t(0x0201228844104000), std::uint64_t(0x080204210C102409),
+    std::uint64_t(0x0104100022011048), std::uint64_t(0x0030084000420210),
+    std::uint64_t(0x1200082C20085040), std::uint64_t(0x0860080490021200),
+    std::uint64_t(0x0000C08208010510), std::uint64_t(0x014811080A140122),};
+
+constexpr static std::uint64_t rook_magics[64] = {
+    std::uint64_t(0x2080008040002012), std::uint64_t(0x414000D0002000C0),
+    std::uint64_t(0x0280100020018089), std::uint64_t(0x0B00081003002004),
+    std::uint64_t(0x2A00200810040200), std::uint64_t(0x0300030004000802),
+    std::uint64_t(0x0300440181000600), std::uint64_t(0x0200084082010424),
+    std::uint64_t(0x0000800080204006), std::uint64_t(0x0000808040002000),
+    std::uint64_t(0x0030802000801000), std::uint64_t(0x000A801004080080),
+    std::uint64_t(0x8024808038004400), std::uint64_t(0x0002800200812400),
+    std::uint64_t(0x0104000108100204), std::uint64_t(0x000200204284030A),
+    std::uint64_t(0x1040008000804020), std::uint64_t(0x8040010041002080),
+    std::uint64_t(0x1001010040200010), std::uint64_t(0x0000808008001000),
+    std::uint64_t(0x1010050008010010), std::uint64_t(0xC040080110042040),
+    std::uint64_t(0x0802440008020110), std::uint64_t(0x0401020000804401),
+    std::uint64_t(0x0850208080004000), std::uint64_t(0xC840004040201000),
+    std::uint64_t(0x90C0200280100081), std::uint64_t(0x1210001080080480),
+    std::uint64_t(0x0300080100041100), std::uint64_t(0x2000040080020080),
+    std::uint64_t(0x0000010400100882), std::uint64_t(0x8020104600029403),
+    std::uint64_t(0x0080004000402000), std::uint64_t(0x0000804202002104),
+    std::uint64_t(0x0001801002802000), std::uint64_t(0x0008801000800800),
+    std::uint64_t(0x0C010004B1002800), std::uint64_t(0x0040800400800200),
+    std::uint64_t(0x8308E10824001002), std::uint64_t(0x5184204402000081),
+    std::uint64_t(0x0280800041030028), std::uint64_t(0x2010044220044008),
+    std::uint64_t(0x8000402001010012), std::uint64_t(0x8003001000090020),
+    std::uint64_t(0x8000080004008080), std::uint64_t(0x9802001004020008),
+    std::uint64_t(0x4100020001008080), std::uint64_t(0x0000040080420001),
+    std::uint64_t(0xA200932045020200), std::uint64_t(0x0838400084200080),
+    std::uint64_t(0x0000200180900280), std::uint64_t(0x02C4200810010100),
+    std::uint64_t(0x4001800800040180), std::uint64_t(0x0530040002008080),
+    std::uint64_t(0x00A3008402000100), std::uint64_t(0xA004104100840200),
+    std::uint64_t(0x0000800040201901), std::uint64_t(0x0809504280620102),
+    std::uint64_t(0x0044100820030041), std::uint64_t(0x0006000408401022),
+    std::uint64_t(0x2002010408102002), std::uint64_t(0x0402006104083002),
+    std::uint64_t(0x051421121000880C), std::uint64_t(0x1070888C01410722),};
+
+}  // namespace libchess::magics
+
+#endif  // LIBCHESS_MAGICNUMBERS_H
@@ -1,39 +1,123 @@
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <iomanip>
+#include <map>
+#include <optional>
 #include <string>
 #include <string_view>
+#include <thread>
+#include <vector>
 
 #include "../Position.h"
 
 using namespace libchess;
 using namespace constants;
 
+// Leaves are bulk counted without materializing their move lists. The side-to-move overloads skip
+// the 150-halfmove and fivefold-repetition cutoffs, so counts depend only on the position, which
+// is also what makes caching them by hash sound.
 inline long long int perft(Position& pos, int depth) {
-    long long int count = 0LL;
-    MoveList move_list = pos.legal_move_list();
     if (depth == 1) {
-        return move_list.size();
+        return pos.legal_move_count(pos.side_to_move());
     }
-    for (Move move : move_list) {
-        pos.make_move(move);
+    long long int count = 0LL;
+    for (Move move : pos.legal_move_list(pos.side_to_move())) {
+        pos.make_generated_move(move);
         count += perft(pos, depth - 1);
-        pos.unmake_move();
+        pos.unmake_generated_move();
     }
     return count;
 }
 
-int main(int argc, char** argv) {
-    if (argc != 3) {
-        std::cout << "Usage: ./libchess_perft <file-path> <max-depth>\n";
-        return 1;
+// A lockless (hash, depth) -> count cache shared by all threads. Each slot stores the key XORed
+// with its data, so a slot torn by a concurrent write fails verification and reads as a miss.
+class PerftTable {
+   public:
+    explicit PerftTable(std::size_t size_mb) {
+        std::size_t num_slots = 1;
+        while (num_slots * 2 * sizeof(Slot) <= size_mb * 1024 * 1024) {
+            num_slots *= 2;
+        }
+        slots_ = std::vector<Slot>(num_slots);
+        mask_ = num_slots - 1;
     }
-    std::string epd_path = argv[1];
-    int max_depth = std::atoi(argv[2]);
+
+    std::optional<long long int> probe(Position::hash_type hash, int depth) const {
+        const Slot& slot = slots_[hash & mask_];
+        std::uint64_t data = slot.data.load(std::memory_order_relaxed);
+        std::uint64_t key = slot.key_xor_data.load(std::memory_order_relaxed) ^ data;
+        if (key != hash || int(data & DEPTH_MASK) != depth) {
+            return std::nullopt;
+        }
+        return data >> DEPTH_BITS;
+    }
+
+    void store(Position::hash_type hash, int depth, long long int count) {
+        Slot& slot = slots_[hash & mask_];
+        std::uint64_t data = (std::uint64_t(count) << DEPTH_BITS) | std::uint64_t(depth);
+        slot.key_xor_data.store(hash ^ data, std::memory_order_relaxed);
+        slot.data.store(data, std::memory_order_relaxed);
+    }
+
+   private:
+    constexpr static int DEPTH_BITS = 8;
+    constexpr static std::uint64_t DEPTH_MASK = (1 << DEPTH_BITS) - 1;
+
+    struct Slot {
+        std::atomic<std::uint64_t> key_xor_data{0};
+        std::atomic<std::uint64_t> data{0};
+    };
+
+    std::vector<Slot> slots_;
+    std::size_t mask_;
+};
+
+// Depth 1 counts are cheaper to generate than to look up, so only interior nodes are cached
+inline long long int perft(Position& pos, int depth, PerftTable* table) {
+    if (!table) {
+        return perft(pos, depth);
+    }
+    if (depth == 1) {
+        return pos.legal_move_count(pos.side_to_move());
+    }
+    auto cached_count = table->probe(pos.hash(), depth);
+    if (cached_count) {
+        return *cached_count;
+    }
+    long long int count = 0LL;
+    for (Move move : pos.legal_move_list(pos.side_to_move())) {
+        pos.make_generated_move(move);
+        count += perft(pos, depth - 1, table);
+        pos.unmake_generated_move();
+    }
+    table->store(pos.hash(), depth, count);
+    return count;
+}
+
+struct PerftEntry {
+    int line_nr;
+    std::string line;
+    std::string fen;
+    int depth;
+    long long int expected_result;
+};
+
+// A unit of work for the thread pool: one root move of an entry, or the whole entry at depth 1
+struct PerftTask {
+    std::size_t entry_index;
+    std::optional<Move> root_move;
+};
+
+std::vector<PerftEntry> read_epd(const std::string& epd_path, int max_depth) {
+    std::vector<PerftEntry> entries;
     std::ifstream file{epd_path};
     std::string line;
     int line_nr = 0;
-    bool failed = false;
     while (std::getline(file, line)) {
         line_nr++;
         std::string_view line_view{line};
@@ -41,8 +125,7 @@ int main(int argc, char** argv) {
         if (delim_pos == std::string_view::npos) {
             break;
         }
-        auto fen = line_view.substr(0, delim_pos);
-        Position pos = *Position::from_fen(fen.data());
+        std::string fen{line_view.substr(0, delim_pos)};
         while (true) {
             auto start_pos = delim_pos + 2;
             delim_pos = line_view.find_first_of(';', start_pos);
@@ -58,27 +141,359 @@ int main(int argc, char** argv) {
                 break;
             }
             auto expected_result = std::strtoll(result_token.begin(), &endptr, 10);
-            auto start_ts = std::chrono::system_clock::now();
-            auto actual_result = perft(pos, depth);
-            auto end_ts = std::chrono::system_clock::now();
-            std::chrono::duration<double> diff_ts = end_ts - start_ts;
-            if (actual_result != expected_result) {
-                std::cout << "FAILED EPD: " << line << " (" << line_nr << ")\n";
-                std::cout << "EXPECTED: " << expected_result << ", GOT: " << actual_result << "\n";
-                failed = true;
+            entries.push_back(PerftEntry{line_nr, line, fen, int(depth), expected_result});
+        }
+    }
+    return entries;
+}
+
+// Runs every entry on the calling thread, timing each one separately
+std::vector<long long int> run_sequential(const std::vector<PerftEntry>& entries,
+                                          PerftTable* table,
+                                          std::vector<double>& times_s) {
+    std::vector<long long int> results;
+    for (const PerftEntry& entry : entries) {
+        Position pos = *Position::from_fen(entry.fen);
+        auto start_ts = std::chrono::steady_clock::now();
+        results.push_back(perft(pos, entry.depth, table));
+        auto end_ts = std::chrono::steady_clock::now();
+        times_s.push_back(std::chrono::duration<double>(end_ts - start_ts).count());
+    }
+    return results;
+}
+
+// Splits every entry into its root moves and lets a pool of workers pull tasks until none are
+// left. Each task sets up its own Position, so workers share nothing but the task counter and the
+// per-entry node counts.
+std::vector<long long int> run_parallel(const std::vector<PerftEntry>& entries,
+                                        PerftTable* table,
+                                        int num_threads) {
+    std::vector<PerftTask> tasks;
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        if (entries[i].depth == 1) {
+            tasks.push_back(PerftTask{i, std::nullopt});
+            continue;
+        }
+        Position pos = *Position::from_fen(entries[i].fen);
+        for (Move move : pos.legal_move_list(pos.side_to_move())) {
+            tasks.push_back(PerftTask{i, move});
+        }
+    }
+
+    std::vector<std::atomic<long long int>> counts(entries.size());
+    std::atomic<std::size_t> next_task{0};
+    auto worker = [&]() {
+        while (true) {
+            std::size_t task_index = next_task.fetch_add(1, std::memory_order_relaxed);
+            if (task_index >= tasks.size()) {
+                return;
+            }
+            const PerftTask& task = tasks[task_index];
+            const PerftEntry& entry = entries[task.entry_index];
+            Position pos = *Position::from_fen(entry.fen);
+            long long int count;
+            if (task.root_move) {
+                pos.make_generated_move(*task.root_move);
+                count = perft(pos, entry.depth - 1, table);
             } else {
-                double time_s = diff_ts.count();
-                double nps = time_s > 0.0 ? actual_result / time_s : actual_result;
-                std::cout << "line: " << line_nr << ", depth: " << depth
-                          << ", nps: " << std::setprecision(4) << nps
-                          << ", count: " << actual_result << "\n";
+                count = perft(pos, entry.depth, table);
+            }
+            counts[task.entry_index].fetch_add(count, std::memory_order_relaxed);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; ++i) {
+        threads.emplace_back(worker);
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<long long int> results;
+    for (const auto& count : counts) {
+        results.push_back(count.load());
+    }
+    return results;
+}
+
+// Prints the node count below each root move, for bisecting a mismatch against another engine
+int divide(const std::string& fen, int depth, PerftTable* table) {
+    auto pos = Position::from_fen(fen);
+    if (!pos || depth < 1) {
+        std::cout << "Invalid FEN or depth\n";
+        return 1;
+    }
+    long long int total_nodes = 0LL;
+    MoveList move_list = pos->legal_move_list(pos->side_to_move());
+    for (Move move : move_list) {
+        long long int count = 1LL;
+        if (depth > 1) {
+            pos->make_generated_move(move);
+            count = perft(*pos, depth - 1, table);
+            pos->unmake_generated_move();
+        }
+        total_nodes += count;
+        std::cout << move << ": " << count << "\n";
+    }
+    std::cout << "\nMoves: " << move_list.size() << ", count: " << total_nodes << "\n";
+    return 0;
+}
+
+struct BenchPosition {
+    const char* name;
+    const char* fen;
+    int depth;
+    long long int expected_result;
+};
+
+// A fixed workload, so that results stay comparable between builds and machines
+constexpr BenchPosition BENCH_POSITIONS[] = {
+    {"startpos", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5, 4865609},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4, 4085603},
+    {"position3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 6, 11030083},
+    {"position4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 5, 15833292},
+    {"position5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4, 2103487},
+    {"position6",
+     "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+     4,
+     3894594},
+};
+
+struct PerftOptions {
+    int num_threads = 1;
+    int hash_mb = 0;
+    int runs = 5;
+    std::string format = "json";
+    std::string baseline_path;
+    double tolerance_pct = 5.0;
+};
+
+bool parse_options(int argc, char** argv, int first_option, PerftOptions& options) {
+    if (argc < first_option || (argc - first_option) % 2 != 0) {
+        return false;
+    }
+    for (int i = first_option; i < argc; i += 2) {
+        std::string_view name = argv[i];
+        const char* value = argv[i + 1];
+        if (name == "--threads") {
+            options.num_threads = std::max(1, std::atoi(value));
+        } else if (name == "--hash") {
+            options.hash_mb = std::max(0, std::atoi(value));
+        } else if (name == "--runs") {
+            options.runs = std::max(1, std::atoi(value));
+        } else if (name == "--format" && (std::strcmp(value, "json") == 0 ||
+                                         std::strcmp(value, "csv") == 0)) {
+            options.format = value;
+        } else if (name == "--baseline") {
+            options.baseline_path = value;
+        } else if (name == "--tolerance") {
+            options.tolerance_pct = std::atof(value);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Reads the median nps per position name from a file written by `bench --format csv`
+std::optional<std::map<std::string, double>> read_baseline(const std::string& baseline_path) {
+    std::ifstream file{baseline_path};
+    if (!file) {
+        return std::nullopt;
+    }
+    std::map<std::string, double> baseline_nps;
+    std::string line;
+    std::getline(file, line);
+    while (std::getline(file, line)) {
+        std::vector<std::string> fields;
+        std::size_t start_pos = 0;
+        while (true) {
+            auto delim_pos = line.find(',', start_pos);
+            fields.push_back(line.substr(start_pos, delim_pos - start_pos));
+            if (delim_pos == std::string::npos) {
+                break;
+            }
+            start_pos = delim_pos + 1;
+        }
+        if (fields.size() >= 4) {
+            baseline_nps[fields[0]] = std::atof(fields[3].c_str());
+        }
+    }
+    return baseline_nps;
+}
+
+// Runs every bench position several times and reports the median and standard deviation of its
+// nps. Returns 1 if a count is wrong and 2 if a median falls more than the tolerance below the
+// baseline.
+int bench(const PerftOptions& options) {
+    struct BenchResult {
+        const BenchPosition* position;
+        double median_nps;
+        double stddev_nps;
+    };
+
+    std::vector<BenchResult> results;
+    for (const BenchPosition& bench_position : BENCH_POSITIONS) {
+        Position pos = *Position::from_fen(bench_position.fen);
+        std::vector<double> nps_runs;
+        for (int run = 0; run < options.runs; ++run) {
+            auto start_ts = std::chrono::steady_clock::now();
+            long long int actual_result = perft(pos, bench_position.depth);
+            auto end_ts = std::chrono::steady_clock::now();
+            if (actual_result != bench_position.expected_result) {
+                std::cerr << "FAILED: " << bench_position.name << ", EXPECTED: "
+                          << bench_position.expected_result << ", GOT: " << actual_result
+                          << "\n";
+                return 1;
             }
+            double time_s = std::chrono::duration<double>(end_ts - start_ts).count();
+            nps_runs.push_back(time_s > 0.0 ? actual_result / time_s : actual_result);
+        }
+
+        std::sort(nps_runs.begin(), nps_runs.end());
+        std::size_t mid = nps_runs.size() / 2;
+        double median_nps = nps_runs.size() % 2 ? nps_runs[mid]
+                                                : (nps_runs[mid - 1] + nps_runs[mid]) / 2.0;
+        double mean_nps = 0.0;
+        for (double nps : nps_runs) {
+            mean_nps += nps / nps_runs.size();
+        }
+        double variance = 0.0;
+        for (double nps : nps_runs) {
+            variance += (nps - mean_nps) * (nps - mean_nps) / nps_runs.size();
         }
+        results.push_back(BenchResult{&bench_position, median_nps, std::sqrt(variance)});
+    }
+
+    std::cout << std::fixed << std::setprecision(0);
+    if (options.format == "csv") {
+        std::cout << "name,depth,nodes,median_nps,stddev_nps\n";
+        for (const BenchResult& result : results) {
+            std::cout << result.position->name << "," << result.position->depth << ","
+                      << result.position->expected_result << "," << result.median_nps << ","
+                      << result.stddev_nps << "\n";
+        }
+    } else {
+        std::cout << "{\n"
+                  << "  \"slider_attacks\": \"" << lookups::slider_attacks_backend() << "\",\n"
+                  << "  \"runs\": " << options.runs << ",\n"
+                  << "  \"positions\": [\n";
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            const BenchResult& result = results[i];
+            std::cout << "    {\"name\": \"" << result.position->name
+                      << "\", \"depth\": " << result.position->depth
+                      << ", \"nodes\": " << result.position->expected_result
+                      << ", \"median_nps\": " << result.median_nps
+                      << ", \"stddev_nps\": " << result.stddev_nps << "}"
+                      << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        std::cout << "  ]\n}\n";
+    }
+
+    if (options.baseline_path.empty()) {
+        return 0;
+    }
+    auto baseline_nps = read_baseline(options.baseline_path);
+    if (!baseline_nps) {
+        std::cerr << "Cannot read baseline: " << options.baseline_path << "\n";
+        return 1;
+    }
+    bool regressed = false;
+    std::cerr << std::fixed << std::setprecision(1);
+    for (const BenchResult& result : results) {
+        auto baseline_it = baseline_nps->find(result.position->name);
+        if (baseline_it == baseline_nps->end() || baseline_it->second <= 0.0) {
+            continue;
+        }
+        double drop_pct = (1.0 - result.median_nps / baseline_it->second) * 100.0;
+        if (drop_pct > options.tolerance_pct) {
+            std::cerr << "REGRESSION: " << result.position->name << " is " << drop_pct
+                      << "% below the baseline (tolerance " << options.tolerance_pct << "%)\n";
+            regressed = true;
+        }
+    }
+    return regressed ? 2 : 0;
+}
+
+int main(int argc, char** argv) {
+    auto print_usage = []() {
+        std::cout << "Usage: ./libchess_perft <file-path> <max-depth> [--threads <n>] "
+                     "[--hash <mb>]\n"
+                     "       ./libchess_perft divide <fen> <depth> [--hash <mb>]\n"
+                     "       ./libchess_perft bench [--runs <n>] [--format json|csv] "
+                     "[--baseline <csv-file>] [--tolerance <percent>]\n";
+    };
+    std::string_view command = argc >= 2 ? argv[1] : "";
+    int first_option = command == "divide" ? 4 : command == "bench" ? 2 : 3;
+    PerftOptions options;
+    if (!parse_options(argc, argv, first_option, options)) {
+        print_usage();
+        return 1;
+    }
+    if (command == "bench") {
+        return bench(options);
+    }
+    int num_threads = options.num_threads;
+    int hash_mb = options.hash_mb;
+    std::optional<PerftTable> table;
+    if (hash_mb > 0) {
+        table.emplace(hash_mb);
+    }
+    PerftTable* table_ptr = table ? &*table : nullptr;
+    if (command == "divide") {
+        return divide(argv[2], std::atoi(argv[3]), table_ptr);
+    }
+
+    std::string epd_path = argv[1];
+    int max_depth = std::atoi(argv[2]);
+    std::cout << "Slider attacks: " << lookups::slider_attacks_backend() << "\n";
+    if (num_threads > 1) {
+        std::cout << "Threads: " << num_threads << "\n";
+    }
+    if (table) {
+        std::cout << "Hash: " << hash_mb << " MB\n";
+    }
+
+    std::vector<PerftEntry> entries = read_epd(epd_path, max_depth);
+    std::vector<double> times_s;
+    auto start_ts = std::chrono::steady_clock::now();
+    std::vector<long long int> results =
+        num_threads > 1 ? run_parallel(entries, table_ptr, num_threads)
+                        : run_sequential(entries, table_ptr, times_s);
+    auto end_ts = std::chrono::steady_clock::now();
+    double total_time_s = std::chrono::duration<double>(end_ts - start_ts).count();
+
+    bool failed = false;
+    long long int total_nodes = 0LL;
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        const PerftEntry& entry = entries[i];
+        long long int actual_result = results[i];
+        if (actual_result != entry.expected_result) {
+            std::cout << "FAILED EPD: " << entry.line << " (" << entry.line_nr << ")\n";
+            std::cout << "EXPECTED: " << entry.expected_result << ", GOT: " << actual_result
+                      << "\n";
+            failed = true;
+            continue;
+        }
+        total_nodes += actual_result;
+        std::cout << "line: " << entry.line_nr << ", depth: " << entry.depth;
+        // Entries overlap in time when run in parallel, so only the total nps is meaningful
+        if (!times_s.empty()) {
+            double time_s = times_s[i];
+            double nps = time_s > 0.0 ? actual_result / time_s : actual_result;
+            std::cout << ", nps: " << std::setprecision(4) << nps;
+        }
+        std::cout << ", count: " << actual_result << "\n";
     }
     if (failed) {
         std::cout << "\nPerft suite failed!\n";
         return 1;
     }
+    if (total_time_s > 0.0) {
+        std::cout << "\nTotal nps: " << std::setprecision(4) << total_nodes / total_time_s
+                  << ", count: " << total_nodes << "\n";
+    }
     std::cout << "\nPerft suite passed!\n";
     return 0;
 }
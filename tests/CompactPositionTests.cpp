@@ -0,0 +1,123 @@
+#include <catch2/catch_all.hpp>
+
+#include "../CompactPosition.h"
+
+using namespace libchess;
+using namespace constants;
+
+namespace {
+
+void require_same_position(const CompactPosition& compact_pos, const Position& pos) {
+    for (PieceType pt : PIECE_TYPES) {
+        REQUIRE(compact_pos.piece_type_bb(pt) == pos.piece_type_bb(pt));
+    }
+    for (Color c : COLORS) {
+        REQUIRE(compact_pos.color_bb(c) == pos.color_bb(c));
+    }
+    REQUIRE(compact_pos.side_to_move() == pos.side_to_move());
+    REQUIRE(compact_pos.castling_rights().value() == pos.castling_rights().value());
+    REQUIRE(compact_pos.enpassant_square() == pos.enpassant_square());
+    REQUIRE(compact_pos.halfmoves() == pos.halfmoves());
+    REQUIRE(compact_pos.fullmoves() == pos.fullmoves());
+    REQUIRE(compact_pos.hash() == pos.hash());
+    REQUIRE(compact_pos.in_check() == pos.in_check());
+}
+
+}  // namespace
+
+TEST_CASE("CompactPosition Conversion Test", "[CompactPosition]") {
+    Position pos{"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 3 17"};
+    CompactPosition compact_pos{pos};
+    require_same_position(compact_pos, pos);
+
+    Position round_trip = compact_pos.to_position();
+    REQUIRE(round_trip.fen() == pos.fen());
+    REQUIRE(round_trip.hash() == pos.hash());
+    REQUIRE(round_trip.legal_move_list().size() == pos.legal_move_list().size());
+}
+
+TEST_CASE("CompactPosition Copy-Make Test", "[CompactPosition]") {
+    std::vector<std::string> fens = {
+        STARTPOS_FEN,
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    };
+    for (const auto& fen : fens) {
+        Position pos{fen};
+        CompactPosition root{pos};
+        for (Move move : pos.legal_move_list()) {
+            CompactPosition child = root.after(move);
+            pos.make_move(move);
+            require_same_position(child, pos);
+            for (Move reply : pos.legal_move_list()) {
+                CompactPosition grandchild = child.after(reply);
+                pos.make_move(reply);
+                require_same_position(grandchild, pos);
+                pos.unmake_move();
+            }
+            pos.unmake_move();
+        }
+        require_same_position(root, pos);
+
+        root.make_null_move();
+        pos.make_null_move();
+        require_same_position(root, pos);
+    }
+}
+
+namespace {
+
+long long int compact_perft(const CompactPosition& pos, int depth) {
+    MoveList move_list = pos.legal_move_list();
+    if (depth == 1) {
+        return move_list.size();
+    }
+    long long int count = 0LL;
+    for (Move move : move_list) {
+        count += compact_perft(pos.after(move), depth - 1);
+    }
+    return count;
+}
+
+}  // namespace
+
+TEST_CASE("CompactPosition Copy-Make Perft Test", "[CompactPosition]") {
+    std::vector<std::pair<std::string, std::vector<long long int>>> perfts = {
+        {STARTPOS_FEN, {20, 400, 8902, 197281}},
+        {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+         {48, 2039, 97862}},
+        {"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", {14, 191, 2812, 43238}},
+        {"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", {6, 264, 9467}},
+        {"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", {44, 1486, 62379}},
+    };
+    for (const auto& [fen, counts] : perfts) {
+        CompactPosition pos{Position{fen}};
+        for (std::size_t depth = 1; depth <= counts.size(); ++depth) {
+            REQUIRE(compact_perft(pos, depth) == counts[depth - 1]);
+        }
+    }
+}
+
+TEST_CASE("CompactPosition Legal Move List Test", "[CompactPosition]") {
+    // Same moves, with the same types, as Position generates
+    Position pos{"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1"};
+    pos.make_move(Move{A2, A4});
+    for (const Position& p : {pos, Position{"8/8/8/KPp4r/8/8/8/7k w - c6 0 1"},
+                              Position{"4k3/8/8/8/1b6/8/3P4/4K3 w - - 0 1"}}) {
+        MoveList expected = p.legal_move_list();
+        MoveList actual = CompactPosition{p}.legal_move_list();
+        REQUIRE(actual.size() == expected.size());
+        for (Move move : expected) {
+            bool found = false;
+            for (Move compact_move : actual) {
+                found |= compact_move.value() == move.value();
+            }
+            REQUIRE(found);
+        }
+    }
+
+    Position round_trip = CompactPosition{pos}.to_position();
+    round_trip.make_move(Move{B4, A3, Move::Type::ENPASSANT});
+    REQUIRE(round_trip.start_fen() == CompactPosition{pos}.to_position().fen());
+}
@@ -0,0 +1,49 @@
+#include <catch2/catch_all.hpp>
+
+#include "../Lookups.h"
+
+using namespace libchess;
+using namespace constants;
+
+TEST_CASE("Slider Attack Backends Test", "[Lookups]") {
+    std::uint64_t seed = 0x9E3779B97F4A7C15;
+    int mismatches = 0;
+    for (Square sq : SQUARES) {
+        for (const auto& magic : {lookups::BISHOP_MAGICS[sq], lookups::ROOK_MAGICS[sq]}) {
+            std::uint64_t subset = 0;
+            do {
+                seed ^= seed << 13;
+                seed ^= seed >> 7;
+                seed ^= seed << 17;
+                Bitboard occupancy{subset | (seed & ~magic.mask)};
+                mismatches += lookups::magic::bishop_attacks(sq, occupancy) !=
+                              lookups::ray::bishop_attacks(sq, occupancy);
+                mismatches += lookups::magic::rook_attacks(sq, occupancy) !=
+                              lookups::ray::rook_attacks(sq, occupancy);
+                mismatches += lookups::magic::queen_attacks(sq, occupancy) !=
+                              lookups::ray::queen_attacks(sq, occupancy);
+#if defined(LIBCHESS_PEXT_ATTACKS)
+                if (lookups::HAS_FAST_PEXT) {
+                    mismatches += lookups::pext::queen_attacks(sq, occupancy) !=
+                                  lookups::ray::queen_attacks(sq, occupancy);
+                }
+#endif
+                subset = (subset - magic.mask) & magic.mask;
+            } while (subset);
+        }
+    }
+    REQUIRE(mismatches == 0);
+}
+
+TEST_CASE("Slider Attacks Test", "[Lookups]") {
+    Bitboard occupancy = Bitboard{C2} | Bitboard{E6} | Bitboard{G4} | Bitboard{B4};
+    REQUIRE(lookups::bishop_attacks(E4, occupancy) ==
+            (Bitboard{D3} | Bitboard{C2} | Bitboard{F3} | Bitboard{G2} |
+             Bitboard{H1} | Bitboard{D5} | Bitboard{C6} | Bitboard{B7} | Bitboard{A8} |
+             Bitboard{F5} | Bitboard{G6} | Bitboard{H7}));
+    REQUIRE(lookups::rook_attacks(E4, occupancy) ==
+            (Bitboard{E1} | Bitboard{E2} | Bitboard{E3} | Bitboard{E5} | Bitboard{E6} |
+             Bitboard{D4} | Bitboard{C4} | Bitboard{B4} | Bitboard{F4} | Bitboard{G4}));
+    REQUIRE(lookups::queen_attacks(E4, occupancy) ==
+            (lookups::bishop_attacks(E4, occupancy) | lookups::rook_attacks(E4, occupancy)));
+}
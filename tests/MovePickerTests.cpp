@@ -0,0 +1,70 @@
+#include <catch2/catch_all.hpp>
+
+#include "../MovePicker.h"
+
+using namespace libchess;
+using namespace constants;
+
+namespace {
+
+MoveList picked_moves(MovePicker& move_picker) {
+    MoveList move_list;
+    while (auto move = move_picker.next()) {
+        REQUIRE(!move_list.contains(*move));
+        move_list.add(*move);
+    }
+    return move_list;
+}
+
+}  // namespace
+
+TEST_CASE("MovePicker Yields Every Move Once Test", "[MovePicker]") {
+    std::vector<std::string> fens = {
+        STARTPOS_FEN,
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "4k3/8/8/8/1b6/8/4P3/4K1N1 w - - 0 1",
+    };
+    for (const auto& fen : fens) {
+        Position pos{fen};
+        MovePicker move_picker{pos};
+        MoveList picked = picked_moves(move_picker);
+        MoveList expected = pos.pseudo_legal_move_list();
+        REQUIRE(picked.size() == expected.size());
+        for (Move move : expected) {
+            REQUIRE(picked.contains(move));
+        }
+    }
+}
+
+TEST_CASE("MovePicker Stage Order Test", "[MovePicker]") {
+    Position pos{"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1"};
+    MovePicker::HistoryTable history{};
+    history[WHITE.value()][A2.value()][A3.value()] = 100;
+    Move tt_move{E2, A6};
+    Move killer{D5, D6};
+    MovePicker move_picker{pos, tt_move, {killer, Move{G2, G4}}, &history};
+    MoveList picked = picked_moves(move_picker);
+
+    REQUIRE(picked.size() == pos.pseudo_legal_move_list().size());
+    REQUIRE(picked.begin()[0] == tt_move);
+    REQUIRE(picked.begin()[0].type() == Move::Type::CAPTURE);
+    int i = 1;
+    for (; pos.is_capture_move(picked.begin()[i]); ++i) {
+    }
+    REQUIRE(i > 1);
+    REQUIRE(picked.begin()[i] == killer);
+    REQUIRE(picked.begin()[i + 1] == Move{G2, G4});
+    REQUIRE(picked.begin()[i + 2] == Move{A2, A3});
+    for (++i; i < picked.size(); ++i) {
+        REQUIRE(!pos.is_capture_move(picked.begin()[i]));
+    }
+}
+
+TEST_CASE("MovePicker Invalid TT Move And Killers Test", "[MovePicker]") {
+    Position pos{STARTPOS_FEN};
+    MovePicker move_picker{pos, Move{E2, E5}, {Move{A1, A2}, Move{G1, E2}}};
+    MoveList picked = picked_moves(move_picker);
+    REQUIRE(picked.size() == 20);
+    REQUIRE(!picked.contains(Move{E2, E5}));
+}
@@ -61,3 +61,28 @@ TEST_CASE("Default Initialization test", "[Move]") {
     REQUIRE(moves[0] == Move(0));
     REQUIRE(moves[1] == Move(0));
 }
+
+TEST_CASE("MoveList Test", "[Move]") {
+    MoveList move_list;
+    REQUIRE(move_list.empty());
+    move_list.add(Move{E2, E4, Move::Type::DOUBLE_PUSH});
+    move_list.add(Move{G1, F3, Move::Type::NORMAL});
+    move_list.add(Move{D2, D3, Move::Type::NORMAL});
+    REQUIRE(move_list.size() == 3);
+    REQUIRE(move_list.contains(Move{G1, F3}));
+    REQUIRE(!move_list.contains(Move{G1, H3}));
+
+    move_list.sort([](Move move) { return move.to_square().value(); });
+    REQUIRE(*move_list.begin() == Move{E2, E4});
+    REQUIRE(*(move_list.end() - 1) == Move{D2, D3});
+
+    move_list.pop_back();
+    REQUIRE(move_list.size() == 2);
+    REQUIRE(!move_list.contains(Move{D2, D3}));
+
+    MoveList copy = move_list;
+    copy.add(move_list);
+    REQUIRE(copy.size() == 4);
+    move_list.clear();
+    REQUIRE(move_list.empty());
+}
@@ -0,0 +1,76 @@
+#include <catch2/catch_all.hpp>
+
+#include "../PawnHashTable.h"
+
+using namespace libchess;
+using namespace constants;
+
+namespace {
+
+struct PawnEval {
+    Bitboard passed_pawns[2];
+    int mg_score = 0;
+    int eg_score = 0;
+};
+
+PawnEval evaluate_pawns(const Position& pos) {
+    PawnEval pawn_eval;
+    for (Color c : COLORS) {
+        Bitboard pawns = pos.piece_type_bb(PAWN, c);
+        pawn_eval.passed_pawns[c.value()] = pawns & lookups::relative_rank_mask(RANK_7, c);
+        int sign = c == WHITE ? 1 : -1;
+        pawn_eval.mg_score += sign * 10 * pawns.popcount();
+        pawn_eval.eg_score += sign * 15 * pawns.popcount();
+    }
+    return pawn_eval;
+}
+
+}  // namespace
+
+TEST_CASE("Pawn Hash Table Probe Test", "[PawnHashTable]") {
+    PawnHashTable<PawnEval> pawn_table{1};
+    Position pos{"4k3/1P6/8/3p4/8/8/5PP1/4K3 w - - 0 1"};
+    REQUIRE(pawn_table.probe(pos.pawn_hash()) == nullptr);
+    REQUIRE(pawn_table.misses() == 1);
+
+    int num_evaluations = 0;
+    auto counting_evaluate = [&](const Position& p) {
+        ++num_evaluations;
+        return evaluate_pawns(p);
+    };
+    const PawnEval& pawn_eval = pawn_table.probe_or_evaluate(pos, counting_evaluate);
+    REQUIRE(pawn_eval.passed_pawns[WHITE.value()] == Bitboard{B7});
+    REQUIRE(pawn_eval.mg_score == 20);
+    REQUIRE(pawn_eval.eg_score == 30);
+
+    // Piece moves keep the pawn key, so the structure is evaluated only once
+    pos.make_move(Move{E1, D2});
+    pos.make_move(Move{E8, D7});
+    REQUIRE(pawn_table.probe_or_evaluate(pos, counting_evaluate).mg_score == 20);
+    REQUIRE(num_evaluations == 1);
+    pos.make_move(Move{G2, G4});
+    REQUIRE(pawn_table.probe_or_evaluate(pos, counting_evaluate).mg_score == 20);
+    REQUIRE(num_evaluations == 2);
+
+    REQUIRE(pawn_table.hits() == 1);
+    REQUIRE(pawn_table.misses() == 3);
+    REQUIRE(pawn_table.hit_rate() == 0.25);
+    pawn_table.reset_counters();
+    REQUIRE(pawn_table.hit_rate() == 0.0);
+
+    pawn_table.clear();
+    REQUIRE(pawn_table.probe(pos.pawn_hash()) == nullptr);
+}
+
+TEST_CASE("Pawn Hash Table UCI Option Test", "[PawnHashTable]") {
+    PawnHashTable<PawnEval> pawn_table;
+    UCISpinOption option = pawn_table.uci_option();
+    REQUIRE(option.name() == "PawnHash");
+    REQUIRE(option.value() == PawnHashTable<PawnEval>::DEFAULT_SIZE_MB);
+
+    Position pos{STARTPOS_FEN};
+    pawn_table.store(pos.pawn_hash(), evaluate_pawns(pos));
+    option.set_option(8);
+    REQUIRE(pawn_table.size_mb() == 8);
+    REQUIRE(pawn_table.probe(pos.pawn_hash()) == nullptr);
+}
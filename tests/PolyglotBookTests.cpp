@@ -0,0 +1,105 @@
+#include <catch2/catch_all.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+#include "../PolyglotBook.h"
+
+using namespace libchess;
+using namespace constants;
+
+namespace {
+
+struct RawEntry {
+    std::uint64_t key;
+    std::uint16_t move;
+    std::uint16_t weight;
+};
+
+std::uint16_t encode(Square from, Square to, int promotion = 0) {
+    return std::uint16_t(to.value() | (from.value() << 6) | (promotion << 12));
+}
+
+// Writes the entries sorted by key in the big-endian Polyglot layout, learn field zeroed
+std::string write_book(std::vector<RawEntry> entries) {
+    std::sort(entries.begin(), entries.end(),
+              [](const RawEntry& lhs, const RawEntry& rhs) { return lhs.key < rhs.key; });
+    std::string path = "libchess_test_book.bin";
+    std::ofstream file{path, std::ios::binary};
+    auto write_big_endian = [&](std::uint64_t value, int num_bytes) {
+        for (int i = num_bytes - 1; i >= 0; --i) {
+            file.put(char((value >> (8 * i)) & 0xff));
+        }
+    };
+    for (const RawEntry& entry : entries) {
+        write_big_endian(entry.key, 8);
+        write_big_endian(entry.move, 2);
+        write_big_endian(entry.weight, 2);
+        write_big_endian(0, 4);
+    }
+    return path;
+}
+
+}  // namespace
+
+TEST_CASE("Polyglot Book Probe Test", "[PolyglotBook]") {
+    Position startpos{STARTPOS_FEN};
+    Position castling_pos{"r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1"};
+    Position promotion_pos{"8/P6k/8/8/8/8/8/K7 w - - 0 1"};
+    std::string path = write_book({
+        {startpos.hash(), encode(E2, E4), 3},
+        {startpos.hash(), encode(D2, D4), 1},
+        {startpos.hash(), encode(E2, E5), 7},
+        {castling_pos.hash(), encode(E1, H1), 1},
+        {castling_pos.hash(), encode(E1, A1), 1},
+        {promotion_pos.hash(), encode(A7, A8, 1), 1},
+        {0x1234, encode(A2, A3), 1},
+    });
+
+    auto book = PolyglotBook::open(path);
+    REQUIRE(book);
+    REQUIRE(book->num_entries() == 7);
+
+    // The illegal e2e5 entry is dropped
+    auto book_moves = book->probe(startpos);
+    REQUIRE(book_moves.size() == 2);
+    REQUIRE(book_moves[0].move == Move{E2, E4});
+    REQUIRE(book_moves[0].weight == 3);
+    REQUIRE(book_moves[1].move == Move{D2, D4});
+
+    book_moves = book->probe(castling_pos);
+    REQUIRE(book_moves.size() == 2);
+    REQUIRE(book_moves[0].move == Move{E1, G1});
+    REQUIRE(book_moves[1].move == Move{E1, C1});
+
+    book_moves = book->probe(promotion_pos);
+    REQUIRE(book_moves.size() == 1);
+    REQUIRE(book_moves[0].move == Move{A7, A8, KNIGHT});
+
+    REQUIRE(book->probe(Position{"4k3/8/8/8/8/8/8/4K3 w - - 0 1"}).empty());
+
+    REQUIRE(book->weighted_move(startpos, 0) == Move{E2, E4});
+    REQUIRE(book->weighted_move(startpos, 2) == Move{E2, E4});
+    REQUIRE(book->weighted_move(startpos, 3) == Move{D2, D4});
+    Position empty_pos{"4k3/8/8/8/8/8/8/4K3 b - - 0 1"};
+    REQUIRE_FALSE(book->weighted_move(empty_pos, 0));
+
+    std::remove(path.c_str());
+    REQUIRE_FALSE(PolyglotBook::open(path));
+}
+
+TEST_CASE("Polyglot Move Encoding Test", "[PolyglotBook]") {
+    Position pos{"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1"};
+    for (Move move : pos.legal_move_list()) {
+        REQUIRE(polyglot::decode_move(polyglot::encode_move(move, pos), pos) == move);
+    }
+
+    Position castling_pos{"r3k2r/8/8/8/8/8/8/R3K2R b KQkq - 0 1"};
+    for (Move move : castling_pos.legal_move_list()) {
+        REQUIRE(polyglot::decode_move(polyglot::encode_move(move, castling_pos), castling_pos) ==
+                move);
+    }
+    REQUIRE(polyglot::encode_move(Move{E8, G8}, castling_pos) == encode(E8, H8));
+    REQUIRE(polyglot::encode_move(Move{E8, C8}, castling_pos) == encode(E8, A8));
+}
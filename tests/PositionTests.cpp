@@ -220,6 +220,53 @@ TEST_CASE("Repetition Test", "[Position]") {
     REQUIRE(pos.halfmoves() == 0);
 }
 
+TEST_CASE("Upcoming Repetition Test", "[Position]") {
+    int num_entries = 0;
+    for (std::uint64_t key : cuckoo::TABLES.keys) {
+        num_entries += key != 0;
+    }
+    REQUIRE(num_entries == 3668);
+
+    Position pos{STARTPOS_FEN};
+    pos.make_move({G1, F3});
+    pos.make_move({G8, F6});
+    REQUIRE(!pos.has_upcoming_repetition(10));
+    pos.make_move({F3, G1});
+    // Nf6-g8 repeats the start position, which only counts as a draw at the root once it occurred
+    // twice
+    REQUIRE(pos.has_upcoming_repetition(4));
+    REQUIRE(!pos.has_upcoming_repetition(0));
+    pos.make_move({F6, G8});
+    pos.make_move({G1, F3});
+    pos.make_move({G8, F6});
+    pos.make_move({F3, G1});
+    REQUIRE(pos.has_upcoming_repetition(0));
+    pos.make_move({E7, E6});
+    REQUIRE(!pos.has_upcoming_repetition(10));
+
+    // Ra3-a1 would return to the first position, unless the a2 pawn is in the way
+    for (std::string fen : {"4k3/8/8/8/8/8/8/R3K3 b - - 0 1", "4k3/8/8/8/8/8/P7/R3K3 b - - 0 1"}) {
+        pos = Position{fen};
+        for (Move move : {Move{E8, D8}, Move{A1, B1}, Move{D8, D7}, Move{B1, B3}, Move{D7, E7},
+                          Move{B3, A3}, Move{E7, E8}}) {
+            pos.make_move(move);
+        }
+        REQUIRE(pos.has_upcoming_repetition(8) == !pos.piece_on(A2));
+    }
+
+    // Null moves break cycles: the start position and Nf3-g1 only recur across them
+    pos = Position{STARTPOS_FEN};
+    pos.make_move({G1, F3});
+    pos.make_null_move();
+    pos.make_move({F3, G1});
+    pos.make_null_move();
+    REQUIRE(pos.hash() == Position{STARTPOS_FEN}.hash());
+    REQUIRE(!pos.is_repeat());
+    REQUIRE(pos.repeat_count() == 0);
+    pos.make_move({G1, F3});
+    REQUIRE(!pos.has_upcoming_repetition(10));
+}
+
 TEST_CASE("FEN Test", "[Position]") {
     Position pos{STARTPOS_FEN};
     REQUIRE(pos.fen() == STARTPOS_FEN);
@@ -534,6 +581,48 @@ TEST_CASE("SEE Move Test Promotion Capture", "[Position]") {
     REQUIRE(actual_value == expected_value);
 }
 
+TEST_CASE("SEE Move Test X-Ray Recaptures", "[Position]") {
+    std::string fen = "1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1";
+
+    auto pos = Position::from_fen(fen);
+    if (!pos) {
+        FAIL("Invalid Position from FEN: " + fen);
+    }
+
+    std::array<int, 6> piece_values = {100, 300, 300, 500, 900, 0};
+    REQUIRE(pos->see_for(Move{D3, E5}, piece_values) == 0);
+    REQUIRE(pos->see_ge(Move{D3, E5}, -200, piece_values));
+    REQUIRE_FALSE(pos->see_ge(Move{D3, E5}, -199, piece_values));
+    REQUIRE_FALSE(pos->see_ge(Move{D3, E5}, 0, piece_values));
+}
+
+TEST_CASE("SEE Threshold Test", "[Position]") {
+    std::string fen = "1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1";
+
+    auto pos = Position::from_fen(fen);
+    if (!pos) {
+        FAIL("Invalid Position from FEN: " + fen);
+    }
+
+    REQUIRE(pos->see_ge(Move{E1, E5}, 100));
+    REQUIRE_FALSE(pos->see_ge(Move{E1, E5}, 101));
+    REQUIRE(pos->see_ge(Move{G3, G4}, 0));
+    // Rxd1 Kxd1 trades the rook back
+    REQUIRE(pos->see_ge(Move{E1, D1}, 0));
+    REQUIRE_FALSE(pos->see_ge(Move{E1, D1}, 1));
+}
+
+TEST_CASE("SEE Threshold Test Back Rank Recapture", "[Position]") {
+    // Qxe8 Rxe8 fxe8=Q: the pawn's recapture promotes, so Black can't afford to take back
+    Position pos{"3rn2k/5P2/8/8/4Q3/8/8/K7 w - - 0 1"};
+    std::array<int, 6> piece_values = {100, 300, 300, 500, 900, 0};
+    Move move{E4, E8};
+    int see_value = pos.see_for(move, piece_values);
+    REQUIRE(see_value == 300);
+    REQUIRE(pos.see_ge(move, see_value, piece_values));
+    REQUIRE_FALSE(pos.see_ge(move, see_value + 1, piece_values));
+}
+
 TEST_CASE("Fivefold Repetition Legal Movegen Test", "[Position]") {
     Position pos{constants::STARTPOS_FEN};
     for (int i = 0; i < 4; ++i) {
@@ -547,3 +636,304 @@ TEST_CASE("Fivefold Repetition Legal Movegen Test", "[Position]") {
     REQUIRE(pos.repeat_count() == 4);
     REQUIRE(pos.legal_move_list().empty());
 }
+
+TEST_CASE("Legal Move Generation Test", "[Position]") {
+    std::vector<std::string> fens = {
+        constants::STARTPOS_FEN,
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/8/8/KPp4r/8/8/8/7k w - c6 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "4k3/8/8/8/1b6/8/3P4/4K3 w - - 0 1",
+        "4k3/4r3/8/8/8/8/3PPP2/r2QK3 w - - 0 1",
+    };
+    for (const auto& fen : fens) {
+        Position pos{fen};
+        MoveList legal_moves = pos.legal_move_list();
+        int expected_count = 0;
+        for (Move move : pos.pseudo_legal_move_list()) {
+            Color stm = pos.side_to_move();
+            pos.make_move(move);
+            if (!pos.checkers_to(stm)) {
+                ++expected_count;
+                REQUIRE(legal_moves.contains(move));
+            }
+            pos.unmake_move();
+        }
+        REQUIRE(legal_moves.size() == expected_count);
+    }
+
+    Position pos{"8/8/8/KPp4r/8/8/8/7k w - c6 0 1"};
+    REQUIRE(!pos.legal_move_list().contains(Move{B5, C6}));
+}
+
+TEST_CASE("Side-Specialized Move Generation Test", "[Position]") {
+    Position pos{"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 b kq - 0 1"};
+    MoveList captures;
+    pos.generate<Color::Value::BLACK, Position::GenType::CAPTURES>(captures);
+    MoveList quiets;
+    pos.generate<Color::Value::BLACK, Position::GenType::QUIETS>(quiets);
+    MoveList all;
+    pos.generate<Color::Value::BLACK, Position::GenType::ALL>(all);
+    MoveList pseudo_legal = pos.pseudo_legal_move_list(constants::BLACK);
+    REQUIRE(all.size() == pseudo_legal.size());
+    REQUIRE(captures.size() + quiets.size() == all.size());
+    for (Move move : captures) {
+        REQUIRE(pos.is_capture_move(move));
+        REQUIRE(pseudo_legal.contains(move));
+    }
+    for (Move move : quiets) {
+        REQUIRE(!pos.is_capture_move(move));
+        REQUIRE(pseudo_legal.contains(move));
+    }
+
+    Position check_pos{"4k3/8/8/8/1b6/8/4P3/4K1N1 w - - 0 1"};
+    REQUIRE(check_pos.in_check());
+    MoveList evasions;
+    check_pos.generate<Color::Value::WHITE, Position::GenType::EVASIONS>(evasions);
+    REQUIRE(evasions.size() == check_pos.check_evasion_move_list().size());
+    MoveList legal;
+    check_pos.generate<Color::Value::WHITE, Position::GenType::LEGAL>(legal);
+    REQUIRE(legal.size() == check_pos.legal_move_list().size());
+}
+
+TEST_CASE("Mailbox Consistency Test", "[Position]") {
+    auto require_mailbox_matches_bitboards = [](const Position& pos) {
+        for (Square sq : SQUARES) {
+            auto piece = pos.piece_on(sq);
+            std::optional<Piece> expected;
+            for (Color c : COLORS) {
+                for (PieceType pt : PIECE_TYPES) {
+                    if (pos.piece_type_bb(pt, c) & Bitboard{sq}) {
+                        expected = Piece{pt, c};
+                    }
+                }
+            }
+            REQUIRE(piece == expected);
+        }
+    };
+
+    Position pos{"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1"};
+    for (Move move : pos.legal_move_list()) {
+        pos.make_move(move);
+        require_mailbox_matches_bitboards(pos);
+        for (Move reply : pos.legal_move_list()) {
+            pos.make_move(reply);
+            require_mailbox_matches_bitboards(pos);
+            pos.unmake_move();
+        }
+        pos.unmake_move();
+        require_mailbox_matches_bitboards(pos);
+    }
+    pos.vflip();
+    require_mailbox_matches_bitboards(pos);
+}
+
+TEST_CASE("Cached Check Info Test", "[Position]") {
+    auto require_check_info_matches_board = [](const Position& pos) {
+        Color stm = pos.side_to_move();
+        Square king_sq = pos.piece_type_bb(KING, stm).forward_bitscan();
+        Square enemy_king_sq = pos.piece_type_bb(KING, !stm).forward_bitscan();
+        REQUIRE(pos.king_square(stm) == king_sq);
+        REQUIRE(pos.king_square(!stm) == enemy_king_sq);
+        REQUIRE(pos.checkers() == pos.attackers_to(king_sq, !stm));
+        REQUIRE(pos.in_check() == bool(pos.attackers_to(king_sq, !stm)));
+        Bitboard pinned;
+        for (Square sq : SQUARES) {
+            if (!(pos.color_bb(stm) & Bitboard{sq}) || sq == king_sq) {
+                continue;
+            }
+            Bitboard occupancy = pos.occupancy_bb() ^ Bitboard{sq};
+            Bitboard sliders = pos.color_bb(!stm) & ~pos.piece_type_bb(PAWN) &
+                               ~pos.piece_type_bb(KNIGHT) & ~pos.piece_type_bb(KING);
+            if (pos.attackers_to(king_sq, occupancy) & sliders & ~pos.checkers()) {
+                pinned |= Bitboard{sq};
+            }
+        }
+        REQUIRE(pos.pinned_pieces_of(stm) == pinned);
+        REQUIRE(pos.check_squares(KNIGHT) == lookups::knight_attacks(enemy_king_sq));
+        REQUIRE(pos.check_squares(QUEEN) ==
+                lookups::queen_attacks(enemy_king_sq, pos.occupancy_bb()));
+        REQUIRE(pos.check_squares(KING) == Bitboard{});
+    };
+
+    Position pos{"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1"};
+    require_check_info_matches_board(pos);
+    for (Move move : pos.legal_move_list()) {
+        pos.make_move(move);
+        require_check_info_matches_board(pos);
+        for (Move reply : pos.legal_move_list()) {
+            pos.make_move(reply);
+            require_check_info_matches_board(pos);
+            pos.unmake_move();
+        }
+        pos.unmake_move();
+        require_check_info_matches_board(pos);
+    }
+    pos.make_null_move();
+    require_check_info_matches_board(pos);
+    pos.unmake_move();
+    pos.vflip();
+    require_check_info_matches_board(pos);
+}
+
+TEST_CASE("Pseudo Legal Move Test", "[Position]") {
+    auto require_exact_legality = [](const Position& pos) {
+        MoveList legal_moves = pos.legal_move_list();
+        for (Square from : SQUARES) {
+            for (Square to : SQUARES) {
+                Move candidates[] = {Move{from, to},
+                                     Move{from, to, KNIGHT},
+                                     Move{from, to, QUEEN},
+                                     Move{from, to, Move::Type::NORMAL},
+                                     Move{from, to, Move::Type::CASTLING}};
+                for (Move move : candidates) {
+                    bool is_generated = false;
+                    for (Move legal_move : legal_moves) {
+                        if (legal_move == move && (move.type() == Move::Type::NONE ||
+                                                   legal_move.type() == move.type())) {
+                            is_generated = true;
+                        }
+                    }
+                    REQUIRE(pos.is_legal_move(move) == is_generated);
+                }
+            }
+        }
+    };
+
+    std::string fens[] = {
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        "8/8/8/2k5/3Pp3/8/8/4K2B b - d3 0 1",
+    };
+    for (const auto& fen : fens) {
+        Position pos{fen};
+        require_exact_legality(pos);
+        for (Move move : pos.legal_move_list()) {
+            pos.make_move(move);
+            require_exact_legality(pos);
+            pos.unmake_move();
+        }
+    }
+}
+
+TEST_CASE("Legal Move Count Test", "[Position]") {
+    std::string fens[] = {
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    };
+    for (const auto& fen : fens) {
+        Position pos{fen};
+        REQUIRE(pos.legal_move_count() == pos.legal_move_list().size());
+        for (Move move : pos.legal_move_list()) {
+            pos.make_move(move);
+            REQUIRE(pos.legal_move_count() == pos.legal_move_list().size());
+            for (Move reply : pos.legal_move_list()) {
+                pos.make_move(reply);
+                REQUIRE(pos.legal_move_count() == pos.legal_move_list().size());
+                pos.unmake_move();
+            }
+            pos.unmake_move();
+        }
+    }
+}
+
+TEST_CASE("Deep History Test", "[Position]") {
+    Position pos{STARTPOS_FEN};
+    Move shuffle[4] = {Move{G1, F3}, Move{G8, F6}, Move{F3, G1}, Move{F6, G8}};
+    for (int i = 0; i < 2000; ++i) {
+        pos.make_move(shuffle[i % 4]);
+    }
+    REQUIRE(pos.hash() == Position{STARTPOS_FEN}.hash());
+    for (int i = 0; i < 1999; ++i) {
+        pos.unmake_move();
+    }
+    REQUIRE(pos.previous_move() == Move{G1, F3});
+    pos.unmake_move();
+    REQUIRE(pos.fen() == STARTPOS_FEN);
+    pos.make_null_move();
+    REQUIRE(!pos.previously_captured_piece());
+}
+
+TEST_CASE("Copied History Capacity Test", "[Position]") {
+    struct HistoryView : Position {
+        explicit HistoryView(const Position& pos) : Position(pos) {
+        }
+        bool has_search_headroom() const {
+            return history().capacity() >= std::size_t(ply() + 1 + HISTORY_HEADROOM);
+        }
+    };
+    Position pos{STARTPOS_FEN};
+    pos.make_move(Move{E2, E4});
+    pos.make_move(Move{E7, E5});
+    pos.unmake_move();
+    HistoryView copy{pos};
+    REQUIRE(copy.has_search_headroom());
+    REQUIRE(copy.fen() == pos.fen());
+    copy.make_move(Move{C7, C5});
+    REQUIRE(copy.previous_move() == Move{C7, C5});
+
+    HistoryView assigned{Position{"4k3/8/8/8/8/8/8/4K3 w - - 0 1"}};
+    static_cast<Position&>(assigned) = pos;
+    REQUIRE(assigned.has_search_headroom());
+    REQUIRE(assigned.hash() == pos.hash());
+    REQUIRE(assigned.previous_move() == Move{E2, E4});
+}
+
+TEST_CASE("Incremental Hash Special Moves Test", "[Position]") {
+    Position castling_pos{"r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1"};
+    castling_pos.make_move(Move{E1, G1, Move::Type::CASTLING});
+    REQUIRE(castling_pos.hash() == Position{castling_pos.fen()}.hash());
+    castling_pos.make_move(Move{E8, C8, Move::Type::CASTLING});
+    REQUIRE(castling_pos.hash() == Position{castling_pos.fen()}.hash());
+
+    Position ep_pos{"4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1"};
+    ep_pos.make_move(Move{E5, D6, Move::Type::ENPASSANT});
+    REQUIRE(ep_pos.hash() == Position{ep_pos.fen()}.hash());
+    REQUIRE(ep_pos.hash() == ep_pos.calculate_hash());
+}
+
+TEST_CASE("Generated Move Integration Test", "[Position]") {
+    Position pos{"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1"};
+    Position reference = pos;
+    for (Move move : pos.legal_move_list()) {
+        pos.make_generated_move(move);
+        reference.make_move(Move{move.from_square(), move.to_square(),
+                                 move.promotion_piece_type().value_or(PAWN)});
+        REQUIRE(pos.fen() == reference.fen());
+        REQUIRE(pos.hash() == reference.hash());
+        REQUIRE(pos.previously_captured_piece() == reference.previously_captured_piece());
+        pos.unmake_generated_move();
+        reference.unmake_move();
+        REQUIRE(pos.fen() == reference.fen());
+    }
+}
+
+TEST_CASE("Pawn And Material Keys Test", "[Position]") {
+    Position startpos{STARTPOS_FEN};
+    REQUIRE(startpos.non_pawn_material(WHITE) == 3200);
+    REQUIRE(startpos.non_pawn_material(BLACK) == 3200);
+    REQUIRE(startpos.phase() == Position::MAX_PHASE);
+
+    Position pos{"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1"};
+    for (Move move : pos.legal_move_list()) {
+        pos.make_move(move);
+        Position fresh{pos.fen()};
+        REQUIRE(pos.pawn_hash() == fresh.pawn_hash());
+        REQUIRE(pos.material_hash() == fresh.material_hash());
+        REQUIRE(pos.non_pawn_material(WHITE) == fresh.non_pawn_material(WHITE));
+        REQUIRE(pos.non_pawn_material(BLACK) == fresh.non_pawn_material(BLACK));
+        REQUIRE(pos.phase() == fresh.phase());
+        pos.unmake_move();
+    }
+
+    Position quiet_pos{"4k3/8/8/8/8/8/4P3/4K3 w - - 0 1"};
+    Position::hash_type material_hash = quiet_pos.material_hash();
+    quiet_pos.make_move(Move{E2, E4});
+    REQUIRE(quiet_pos.material_hash() == material_hash);
+    REQUIRE(quiet_pos.pawn_hash() == Position{quiet_pos.fen()}.pawn_hash());
+}
@@ -0,0 +1,89 @@
+#include <catch2/catch_all.hpp>
+
+#include "../TranspositionTable.h"
+
+using namespace libchess;
+using namespace constants;
+
+TEST_CASE("Transposition Table Store And Probe Test", "[TranspositionTable]") {
+    TranspositionTable tt{1};
+    Position pos{STARTPOS_FEN};
+    REQUIRE_FALSE(tt.probe(pos.hash()));
+
+    tt.store(pos.hash(),
+             Move{E2, E4, Move::Type::DOUBLE_PUSH},
+             -35,
+             7,
+             TranspositionTable::Bound::LOWER);
+    auto entry = tt.probe(pos.hash());
+    REQUIRE(entry);
+    REQUIRE(entry->move == Move{E2, E4});
+    REQUIRE(entry->move.type() == Move::Type::NONE);
+    REQUIRE(entry->score == -35);
+    REQUIRE(entry->depth == 7);
+    REQUIRE(entry->bound == TranspositionTable::Bound::LOWER);
+
+    // A result without a move keeps the previously stored one
+    tt.store(pos.hash(), Move{}, 20, -2, TranspositionTable::Bound::EXACT);
+    entry = tt.probe(pos.hash());
+    REQUIRE(entry->move == Move{E2, E4});
+    REQUIRE(entry->depth == -2);
+    REQUIRE(entry->bound == TranspositionTable::Bound::EXACT);
+
+    tt.store(pos.hash(), Move{A7, A8, QUEEN}, 32767, 1, TranspositionTable::Bound::UPPER);
+    REQUIRE(tt.probe(pos.hash())->move == Move{A7, A8, QUEEN});
+    REQUIRE(tt.probe(pos.hash())->score == 32767);
+
+    tt.clear();
+    REQUIRE_FALSE(tt.probe(pos.hash()));
+}
+
+TEST_CASE("Transposition Table Replacement Test", "[TranspositionTable]") {
+    TranspositionTable tt{1};
+    // Keys that differ only above the index bits share a bucket
+    auto key = [](std::uint64_t i) { return (i << 40) | 0x1234; };
+    for (std::uint64_t i = 1; i <= 4; ++i) {
+        tt.store(key(i), Move{}, 0, int(i) * 10, TranspositionTable::Bound::EXACT);
+    }
+    tt.store(key(5), Move{}, 0, 5, TranspositionTable::Bound::EXACT);
+    REQUIRE_FALSE(tt.probe(key(1)));
+    REQUIRE(tt.probe(key(2)));
+    REQUIRE(tt.probe(key(5)));
+
+    // Entries from older searches go first, even when deeper
+    for (int i = 0; i < 4; ++i) {
+        tt.new_search();
+    }
+    tt.store(key(6), Move{}, 0, 1, TranspositionTable::Bound::EXACT);
+    tt.store(key(7), Move{}, 0, 1, TranspositionTable::Bound::EXACT);
+    REQUIRE(tt.probe(key(6)));
+    REQUIRE(tt.probe(key(7)));
+    REQUIRE_FALSE(tt.probe(key(2)));
+    REQUIRE(tt.probe(key(4)));
+}
+
+TEST_CASE("Transposition Table Hashfull Test", "[TranspositionTable]") {
+    TranspositionTable tt{1};
+    REQUIRE(tt.hashfull() == 0);
+    for (std::uint64_t i = 0; i < 250; ++i) {
+        tt.store(i, Move{}, 0, 1, TranspositionTable::Bound::EXACT);
+        tt.store(i | (std::uint64_t(1) << 40), Move{}, 0, 1, TranspositionTable::Bound::EXACT);
+    }
+    REQUIRE(tt.hashfull() == 500);
+    tt.new_search();
+    REQUIRE(tt.hashfull() == 0);
+}
+
+TEST_CASE("Transposition Table UCI Option Test", "[TranspositionTable]") {
+    TranspositionTable tt{1};
+    UCISpinOption hash_option = tt.uci_option();
+    REQUIRE(hash_option.name() == "Hash");
+    REQUIRE(hash_option.value() == 1);
+
+    tt.store(42, Move{}, 0, 1, TranspositionTable::Bound::EXACT);
+    hash_option.set_option(4);
+    REQUIRE(tt.size_mb() == 4);
+    REQUIRE_FALSE(tt.probe(42));
+    hash_option.set_option(0);
+    REQUIRE(tt.size_mb() == 4);
+}